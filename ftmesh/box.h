@@ -0,0 +1,88 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the box class.
+ *
+ * Define an axis aligned bounding box. The meshes and strings compute
+ * their bounding box while being built so one can cull or lay out text
+ * without scanning all the vertices.
+ */
+
+
+// self
+//
+#include    <ftmesh/point.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <limits>
+
+
+
+namespace ftmesh
+{
+
+
+
+struct box
+{
+    bool is_empty() const
+    {
+        return f_max.x() < f_min.x();
+    }
+
+    void add_point(point const & p)
+    {
+        f_min.f_coordinates[0] = std::min(f_min.x(), p.x());
+        f_min.f_coordinates[1] = std::min(f_min.y(), p.y());
+        f_max.f_coordinates[0] = std::max(f_max.x(), p.x());
+        f_max.f_coordinates[1] = std::max(f_max.y(), p.y());
+    }
+
+    void add_box(box const & rhs, double dx = 0.0, double dy = 0.0)
+    {
+        if(!rhs.is_empty())
+        {
+            add_point(point(rhs.f_min.x() + dx, rhs.f_min.y() + dy));
+            add_point(point(rhs.f_max.x() + dx, rhs.f_max.y() + dy));
+        }
+    }
+
+    double width() const
+    {
+        return is_empty() ? 0.0 : f_max.x() - f_min.x();
+    }
+
+    double height() const
+    {
+        return is_empty() ? 0.0 : f_max.y() - f_min.y();
+    }
+
+    point       f_min = point(std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    point       f_max = point(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+};
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
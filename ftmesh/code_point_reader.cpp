@@ -0,0 +1,152 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the code_point_reader class.
+ *
+ * The reader decodes the input one character at a time, directly from
+ * the caller's buffer. This avoids allocating and filling a complete
+ * std::u32string before looking up the first glyph.
+ *
+ * \private
+ */
+
+// self
+//
+#include    "ftmesh/code_point_reader.h"
+
+
+// libutf8
+//
+#include    <libutf8/base.h>
+#include    <libutf8/exception.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+/** \brief Find the length of the complete UTF-8 sequences in \p s.
+ *
+ * When reading a stream in chunks, a multi-byte character may be split
+ * between two chunks. This function returns the length of \p s without
+ * the incomplete sequence found at its end, if any.
+ *
+ * \param[in] s  The UTF-8 buffer to check.
+ *
+ * \return The number of bytes that can be decoded now.
+ */
+std::size_t complete_utf8_length(std::string_view s)
+{
+    std::size_t const length(s.length());
+    for(std::size_t i(1); i <= 3 && i <= length; ++i)
+    {
+        unsigned char const c(s[length - i]);
+        if((c & 0xC0) == 0x80)
+        {
+            continue;       // continuation byte
+        }
+        std::size_t const expected((c & 0xE0) == 0xC0
+                                        ? 2
+                                        : (c & 0xF0) == 0xE0
+                                            ? 3
+                                            : (c & 0xF8) == 0xF0 ? 4 : 1);
+        return expected > i ? length - i : length;
+    }
+    return length;
+}
+
+
+code_point_reader::code_point_reader(std::string_view s)
+    : f_utf8(s.data())
+    , f_utf8_length(s.length())
+{
+}
+
+
+code_point_reader::code_point_reader(std::u32string_view s)
+    : f_utf32(s)
+{
+}
+
+
+/** \brief Read the next code point.
+ *
+ * \exception libutf8::libutf8_exception_decoding
+ * The UTF-8 input is invalid (like libutf8::to_u32string() would).
+ *
+ * \param[out] c  The code point read.
+ *
+ * \return false once the end of the string was reached.
+ */
+bool code_point_reader::next(char32_t & c)
+{
+    if(f_utf8 != nullptr)
+    {
+        if(f_utf8_length == 0)
+        {
+            return false;
+        }
+        if(libutf8::mbstowc(c, f_utf8, f_utf8_length) < 0)
+        {
+            throw libutf8::libutf8_exception_decoding(
+                    "code_point_reader::next(): a UTF-8 character could not be extracted.");
+        }
+        return true;
+    }
+
+    if(f_utf32_pos >= f_utf32.length())
+    {
+        return false;
+    }
+    c = f_utf32[f_utf32_pos];
+    ++f_utf32_pos;
+    return true;
+}
+
+
+/** \brief Return the maximum number of code points left.
+ *
+ * For UTF-8, this is the number of bytes, which is larger or equal to
+ * the number of code points.
+ *
+ * \return The number of code points left, or an upper bound.
+ */
+std::size_t code_point_reader::size_hint() const
+{
+    if(f_utf8 != nullptr)
+    {
+        return f_utf8_length;
+    }
+    return f_utf32.length() - f_utf32_pos;
+}
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,66 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the code_point_reader class.
+ *
+ * The code point reader decodes a UTF-8 or a UTF-32 string one
+ * character at a time.
+ *
+ * \private
+ */
+
+
+// C++
+//
+#include    <string_view>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+class code_point_reader
+{
+public:
+                            code_point_reader(std::string_view s);
+                            code_point_reader(std::u32string_view s);
+
+    bool                    next(char32_t & c);
+    std::size_t             size_hint() const;
+
+private:
+    char const *            f_utf8 = nullptr;
+    std::size_t             f_utf8_length = 0;
+    std::u32string_view     f_utf32 = std::u32string_view();
+    std::size_t             f_utf32_pos = 0;
+};
+
+
+std::size_t                 complete_utf8_length(std::string_view s);
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
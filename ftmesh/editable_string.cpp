@@ -0,0 +1,302 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+
+/** \file
+ * \brief Implementation of the editable_string class.
+ *
+ * The editable_string holds the text, the mesh and the advance of each
+ * character. The advance includes the kerning with the next character,
+ * so inserting or erasing characters changes the advance of the
+ * character just before the edit, the advances of the new characters,
+ * and nothing else.
+ *
+ * The positions are the sums of the advances. They are calculated
+ * lazily: an edit only marks the positions after it as invalid and
+ * they get recalculated the next time a position is requested.
+ */
+
+// self
+//
+#include    "ftmesh/editable_string.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <stdexcept>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+
+/** \brief Initialize an empty editable string.
+ *
+ * The font is used to retrieve the meshes and kerning of the characters
+ * added to the string. It must remain valid as long as the string gets
+ * edited.
+ *
+ * \param[in] f  The font used to convert the characters.
+ */
+editable_string::editable_string(font & f)
+    : f_font(f)
+{
+}
+
+
+/** \brief Replace the whole text.
+ *
+ * \param[in] text  The new text.
+ */
+void editable_string::set_text(std::u32string_view text)
+{
+    replace(0, f_text.length(), text);
+}
+
+
+editable_string::change editable_string::insert(std::size_t pos, std::u32string_view text)
+{
+    return replace(pos, 0, text);
+}
+
+
+editable_string::change editable_string::erase(std::size_t pos, std::size_t count)
+{
+    return replace(pos, count, std::u32string_view());
+}
+
+
+/** \brief Replace \p count characters at \p pos with \p text.
+ *
+ * Only the new characters get converted. The advance of the character
+ * before \p pos is recalculated since its kerning now applies to a
+ * different character. All the other characters keep their mesh and
+ * advance.
+ *
+ * The returned change object describes the glyphs which were modified:
+ * the \p f_erased glyphs starting at \p f_first were replaced by
+ * \p f_inserted glyphs. The glyphs after those did not change except for
+ * their position, which moved by \p f_shift. A renderer can use that
+ * information to only upload the modified glyphs and offset the others.
+ *
+ * \exception std::out_of_range
+ * The \p pos parameter is larger than the size of the string.
+ *
+ * \param[in] pos  The index of the first character to replace.
+ * \param[in] count  The number of characters to replace; it gets clamped
+ * to the end of the string.
+ * \param[in] text  The new characters.
+ *
+ * \return A description of the modified glyphs.
+ */
+editable_string::change editable_string::replace(
+      std::size_t pos
+    , std::size_t count
+    , std::u32string_view text)
+{
+    if(pos > f_text.length())
+    {
+        throw std::out_of_range(
+                  "editable_string position "
+                + std::to_string(pos)
+                + " is out of range (string size is "
+                + std::to_string(f_text.length())
+                + ").");
+    }
+    count = std::min(count, f_text.length() - pos);
+
+    // the character before the edit has its kerning changed
+    //
+    change result;
+    result.f_first = pos > 0 ? pos - 1 : pos;
+    result.f_erased = pos + count - result.f_first;
+    result.f_inserted = pos + text.length() - result.f_first;
+
+    float const old_width(sum_advances(result.f_first, pos + count));
+
+    f_text.replace(pos, count, text);
+    f_meshes.erase(f_meshes.begin() + pos, f_meshes.begin() + pos + count);
+    f_meshes.insert(f_meshes.begin() + pos, text.length(), mesh::pointer_t());
+    f_advances.erase(f_advances.begin() + pos, f_advances.begin() + pos + count);
+    f_advances.insert(f_advances.begin() + pos, text.length(), 0.0f);
+    for(std::size_t idx(0); idx < text.length(); ++idx)
+    {
+        f_meshes[pos + idx] = f_font.get_mesh(text[idx]);
+    }
+    update_advances(result.f_first, pos + text.length());
+
+    result.f_shift = sum_advances(result.f_first, pos + text.length()) - old_width;
+
+    f_positions.resize(f_text.length() + 1);
+    f_valid_positions = std::min(f_valid_positions, result.f_first + 1);
+
+    return result;
+}
+
+
+std::u32string const & editable_string::get_text() const
+{
+    return f_text;
+}
+
+
+std::size_t editable_string::size() const
+{
+    return f_text.length();
+}
+
+
+/** \brief Get the mesh of a character.
+ *
+ * \exception std::out_of_range
+ * The \p index is not a valid character index.
+ *
+ * \param[in] index  The index of the character.
+ *
+ * \return The mesh of the character, which may be a null pointer.
+ */
+mesh::pointer_t editable_string::get_mesh(std::size_t index) const
+{
+    return f_meshes.at(index);
+}
+
+
+/** \brief Get the advance of a character.
+ *
+ * The advance includes the kerning with the next character.
+ *
+ * \exception std::out_of_range
+ * The \p index is not a valid character index.
+ *
+ * \param[in] index  The index of the character.
+ *
+ * \return The advance of the character.
+ */
+float editable_string::get_advance(std::size_t index) const
+{
+    return f_advances.at(index);
+}
+
+
+/** \brief Get the position of a character.
+ *
+ * The positions after the last edit are recalculated up to \p index
+ * if needed. Using size() as the \p index returns the width of the
+ * string.
+ *
+ * \exception std::out_of_range
+ * The \p index is larger than size().
+ *
+ * \param[in] index  The index of the character.
+ *
+ * \return The position of the character.
+ */
+float editable_string::get_position(std::size_t index)
+{
+    if(index > f_text.length())
+    {
+        throw std::out_of_range(
+                  "editable_string index "
+                + std::to_string(index)
+                + " is out of range (string size is "
+                + std::to_string(f_text.length())
+                + ").");
+    }
+    for(; f_valid_positions <= index; ++f_valid_positions)
+    {
+        f_positions[f_valid_positions] = f_positions[f_valid_positions - 1]
+                                       + f_advances[f_valid_positions - 1];
+    }
+    return f_positions[index];
+}
+
+
+float editable_string::get_width()
+{
+    return get_position(f_text.length());
+}
+
+
+/** \brief Create a mesh_string from this string.
+ *
+ * The result is the same as calling font::convert_string() with the
+ * current text, without converting the characters again.
+ *
+ * \return A new mesh_string.
+ */
+mesh_string::pointer_t editable_string::to_mesh_string() const
+{
+    mesh_string::pointer_t result(std::make_shared<mesh_string>());
+    result->reserve(f_text.length());
+    for(std::size_t idx(0); idx < f_text.length(); ++idx)
+    {
+        if(f_meshes[idx] != nullptr)
+        {
+            result->add_glyph(f_meshes[idx], f_advances[idx], f_text[idx]);
+        }
+    }
+    return result;
+}
+
+
+/** \brief Calculate the advances of the characters in [start, end).
+ *
+ * When \p end is not the end of the string, the advance of the character
+ * at \p end - 1 includes the kerning with the character at \p end.
+ *
+ * \param[in] start  The first character to update.
+ * \param[in] end  The character after the last one to update.
+ */
+void editable_string::update_advances(std::size_t start, std::size_t end)
+{
+    for(std::size_t idx(start); idx < end; ++idx)
+    {
+        float advance(0.0f);
+        if(f_meshes[idx] != nullptr)
+        {
+            advance = f_meshes[idx]->get_advance();
+            if(idx + 1 < f_text.length())
+            {
+                advance += f_font.get_kerning(f_text[idx], f_text[idx + 1]);
+            }
+        }
+        f_advances[idx] = advance;
+    }
+}
+
+
+float editable_string::sum_advances(std::size_t start, std::size_t end) const
+{
+    float result(0.0f);
+    for(std::size_t idx(start); idx < end; ++idx)
+    {
+        result += f_advances[idx];
+    }
+    return result;
+}
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
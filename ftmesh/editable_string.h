@@ -0,0 +1,82 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+#pragma once
+
+/** \file
+ * \brief Definitions of the editable_string class.
+ *
+ * A mesh_string is built once by font::convert_string(). Text being
+ * edited would have to be converted again after each key stroke. The
+ * editable_string keeps the meshes and advances of each character and
+ * only updates the characters affected by an edit.
+ */
+
+// self
+//
+#include    <ftmesh/font.h>
+
+
+
+namespace ftmesh
+{
+
+
+class editable_string
+{
+public:
+    typedef std::shared_ptr<editable_string>  pointer_t;
+
+    struct change
+    {
+        std::size_t         f_first = 0;
+        std::size_t         f_erased = 0;
+        std::size_t         f_inserted = 0;
+        float               f_shift = 0.0f;
+    };
+
+                            editable_string(font & f);
+
+    void                    set_text(std::u32string_view text);
+    change                  insert(std::size_t pos, std::u32string_view text);
+    change                  erase(std::size_t pos, std::size_t count);
+    change                  replace(std::size_t pos, std::size_t count, std::u32string_view text);
+
+    std::u32string const &  get_text() const;
+    std::size_t             size() const;
+    mesh::pointer_t         get_mesh(std::size_t index) const;
+    float                   get_advance(std::size_t index) const;
+    float                   get_position(std::size_t index);
+    float                   get_width();
+    mesh_string::pointer_t  to_mesh_string() const;
+
+private:
+    void                    update_advances(std::size_t start, std::size_t end);
+    float                   sum_advances(std::size_t start, std::size_t end) const;
+
+    font &                  f_font;
+    std::u32string          f_text = std::u32string();
+    std::vector<mesh::pointer_t>
+                            f_meshes = std::vector<mesh::pointer_t>();
+    std::vector<float>      f_advances = std::vector<float>();
+    std::vector<float>      f_positions = std::vector<float>(1, 0.0f);
+    std::size_t             f_valid_positions = 1;
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
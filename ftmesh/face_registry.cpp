@@ -0,0 +1,415 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the face_registry class.
+ *
+ * Each font file is mapped in memory once and its faces are created with
+ * FT_New_Memory_Face(). The faces are shared between all the font
+ * objects opening the same file and face index. Each font object has
+ * its own FT_Size (see FT_New_Size()) so fonts sharing a face can still
+ * use different sizes; they activate their size while holding the
+ * face mutex.
+ *
+ * A face no longer used by any font becomes idle. It is kept open, in
+ * case it gets used again soon, until more than the maximum number of
+ * idle faces exist, in which case the least recently used idle faces
+ * get closed.
+ *
+ * \private
+ */
+
+// self
+//
+#include    "ftmesh/face_registry.h"
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C++
+//
+#include    <stdexcept>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <sys/mman.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+namespace
+{
+
+
+FT_Library  g_ft_library;
+
+
+class auto_init_freetype_library
+{
+public:
+    auto_init_freetype_library()
+    {
+        int e(FT_Init_FreeType(&g_ft_library));
+        if(e != 0)
+        {
+            SNAP_LOG_ERROR
+                << "An error occurred initializing the FreeType library ("
+                << e
+                << ")"
+                << SNAP_LOG_SEND;
+        }
+    }
+};
+
+auto_init_freetype_library       g_auto_init_freetype_library = auto_init_freetype_library();
+
+
+} // no name namespace
+
+
+
+/** \brief Map a font file in memory.
+ *
+ * \exception std::runtime_error
+ * The file could not be opened or mapped.
+ *
+ * \param[in] filename  The name of the font file.
+ */
+face_registry::file_mapping::file_mapping(std::string const & filename)
+{
+    int const fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if(fd < 0)
+    {
+        throw std::runtime_error("open() could not open font file \"" + filename + "\".");
+    }
+
+    struct stat st = {};
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("fstat() could not get the size of font file \"" + filename + "\".");
+    }
+    if(st.st_size == 0)
+    {
+        close(fd);
+        throw std::runtime_error("font file \"" + filename + "\" is empty.");
+    }
+    f_id = id_t(st.st_dev, st.st_ino);
+    f_size = st.st_size;
+
+    f_data = mmap(nullptr, f_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(f_data == MAP_FAILED)
+    {
+        f_data = nullptr;
+        throw std::runtime_error("mmap() could not map font file \"" + filename + "\".");
+    }
+}
+
+
+face_registry::file_mapping::~file_mapping()
+{
+    if(f_data != nullptr)
+    {
+        munmap(f_data, f_size);
+    }
+}
+
+
+/** \brief Open a face from a mapped font file.
+ *
+ * \exception std::runtime_error
+ * FreeType could not open the face or the face has no Unicode charmap.
+ *
+ * \param[in] filename  The name of the font file, for errors.
+ * \param[in] face_index  The index of the face in the file.
+ * \param[in] mapping  The file mapped in memory.
+ */
+face_registry::face::face(
+          std::string const & filename
+        , FT_Long face_index
+        , file_mapping::pointer_t mapping)
+    : f_mapping(mapping)
+{
+    FT_Error e(FT_New_Memory_Face(
+              g_ft_library
+            , static_cast<FT_Byte const *>(f_mapping->f_data)
+            , static_cast<FT_Long>(f_mapping->f_size)
+            , face_index
+            , &f_face));
+    if(e != FT_Err_Ok)
+    {
+        throw std::runtime_error(
+                  "FT_New_Memory_Face() could not load \""
+                + filename
+                + "\" (FT_Error: "
+                + std::to_string(e)
+                + ")");
+    }
+
+    e = FT_Select_Charmap(f_face, FT_ENCODING_UNICODE);
+    if(e != FT_Err_Ok)
+    {
+        FT_Done_Face(f_face);
+        throw std::runtime_error(
+                  "FT_Select_Charmap() could not set the Unicode charmap of \""
+                + filename
+                + "\" (FT_Error: "
+                + std::to_string(e)
+                + ")");
+    }
+
+    if(FT_HAS_MULTIPLE_MASTERS(f_face)
+    && FT_Get_MM_Var(f_face, &f_variations) != FT_Err_Ok)
+    {
+        f_variations = nullptr;     // LCOV_EXCL_LINE
+    }
+}
+
+
+face_registry::face::~face()
+{
+    if(f_variations != nullptr)
+    {
+        FT_Done_MM_Var(g_ft_library, f_variations);
+    }
+    FT_Done_Face(f_face);
+}
+
+
+FT_Face face_registry::face::get_face() const
+{
+    return f_face;
+}
+
+
+/** \brief Get the mutex protecting this face.
+ *
+ * All the fonts sharing this face must lock this mutex before using the
+ * face since FreeType faces are not thread safe.
+ *
+ * \return A reference to the face mutex.
+ */
+std::mutex & face_registry::face::get_mutex()
+{
+    return f_mutex;
+}
+
+
+/** \brief Get the axes and named instances of a variable font.
+ *
+ * \return The variation description or nullptr if the face is not a
+ * variable font.
+ */
+FT_MM_Var const * face_registry::face::get_variations() const
+{
+    return f_variations;
+}
+
+
+/** \brief Get the variation coordinates currently applied to the face.
+ *
+ * The variation coordinates are a property of the face, not of the
+ * size, so fonts sharing a face and using different coordinates must
+ * apply theirs each time they lock the face. This vector holds the
+ * coordinates last applied, an empty vector meaning the defaults, so
+ * they only get applied again when they change.
+ *
+ * The caller must hold the face mutex.
+ *
+ * \return A reference to the current coordinates.
+ */
+std::vector<FT_Fixed> & face_registry::face::get_coordinates()
+{
+    return f_coordinates;
+}
+
+
+/** \brief Get the registry.
+ *
+ * The registry is allocated on the first call. The handles returned by
+ * get_face() keep a reference to the registry so it remains valid as
+ * long as a face is in use.
+ *
+ * \return The face registry.
+ */
+face_registry::pointer_t face_registry::get_instance()
+{
+    static pointer_t g_registry(new face_registry());
+    return g_registry;
+}
+
+
+/** \brief Get a face, opening it if not already open.
+ *
+ * The returned handle is shared with all the other fonts using the
+ * same face. When the last handle of a face gets released, the face
+ * becomes idle.
+ *
+ * \exception std::runtime_error
+ * The face could not be opened.
+ *
+ * \param[in] filename  The name of the font file.
+ * \param[in] face_index  The index of the face in the file.
+ *
+ * \return A handle to the face.
+ */
+face_registry::face::pointer_t face_registry::get_face(std::string const & filename, FT_Long face_index)
+{
+    std::string const key(filename + ':' + std::to_string(face_index));
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    auto it(f_faces.find(key));
+    if(it == f_faces.end())
+    {
+        // the same file reached through a different path (i.e. a
+        // symbolic link) shares the same mapping
+        //
+        file_mapping::pointer_t mapping;
+        struct stat st = {};
+        if(stat(filename.c_str(), &st) == 0)
+        {
+            auto const file(f_files.find(file_mapping::id_t(st.st_dev, st.st_ino)));
+            if(file != f_files.end())
+            {
+                mapping = file->second.lock();
+            }
+        }
+        if(mapping == nullptr)
+        {
+            mapping = std::make_shared<file_mapping>(filename);
+            f_files[mapping->f_id] = mapping;
+        }
+
+        entry e;
+        e.f_face = std::make_shared<face>(filename, face_index, mapping);
+        e.f_idle = f_idle_faces.end();
+        it = f_faces.emplace(key, e).first;
+    }
+    else if(it->second.f_users == 0)
+    {
+        f_idle_faces.erase(it->second.f_idle);
+        it->second.f_idle = f_idle_faces.end();
+    }
+    ++it->second.f_users;
+
+    // the handle does not own the face, its deleter tells the registry
+    // that this user is done with it
+    //
+    pointer_t registry(shared_from_this());
+    return face::pointer_t(
+              it->second.f_face.get()
+            , [registry, key](face *)
+              {
+                  registry->release(key);
+              });
+}
+
+
+/** \brief Change the number of idle faces kept open.
+ *
+ * \param[in] max_idle_faces  The maximum number of idle faces.
+ */
+void face_registry::set_max_idle_faces(std::size_t max_idle_faces)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    f_max_idle_faces = max_idle_faces;
+    trim_idle_faces(f_max_idle_faces);
+}
+
+
+/** \brief Close all the idle faces now.
+ */
+void face_registry::close_idle_faces()
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    trim_idle_faces(0);
+}
+
+
+void face_registry::release(std::string const & key)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    auto it(f_faces.find(key));
+    if(it == f_faces.end())
+    {
+        return;     // LCOV_EXCL_LINE
+    }
+
+    --it->second.f_users;
+    if(it->second.f_users == 0)
+    {
+        f_idle_faces.push_front(key);
+        it->second.f_idle = f_idle_faces.begin();
+        trim_idle_faces(f_max_idle_faces);
+    }
+}
+
+
+/** \brief Close the least recently used idle faces.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] max_idle_faces  The number of idle faces to keep.
+ */
+void face_registry::trim_idle_faces(std::size_t max_idle_faces)
+{
+    while(f_idle_faces.size() > max_idle_faces)
+    {
+        f_faces.erase(f_idle_faces.back());
+        f_idle_faces.pop_back();
+    }
+
+    for(auto it(f_files.begin()); it != f_files.end(); )
+    {
+        if(it->second.expired())
+        {
+            it = f_files.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,146 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the face_registry class.
+ *
+ * The face registry opens each font file once and shares the FreeType
+ * faces between all the font objects using them.
+ *
+ * \private
+ */
+
+
+// FreeType
+//
+// ft2build.h must come first
+#include    <ft2build.h>
+
+#include    FT_FREETYPE_H
+#include    FT_MULTIPLE_MASTERS_H
+
+
+// C++
+//
+#include    <list>
+#include    <map>
+#include    <memory>
+#include    <mutex>
+#include    <string>
+#include    <utility>
+#include    <vector>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+constexpr std::size_t const DEFAULT_MAX_IDLE_FACES = 16;
+
+
+class face_registry
+    : public std::enable_shared_from_this<face_registry>
+{
+public:
+    typedef std::shared_ptr<face_registry>  pointer_t;
+
+    struct file_mapping
+    {
+        typedef std::shared_ptr<file_mapping>   pointer_t;
+        typedef std::pair<dev_t, ino_t>         id_t;
+
+                                file_mapping(std::string const & filename);
+                                file_mapping(file_mapping const &) = delete;
+                                ~file_mapping();
+        file_mapping &          operator = (file_mapping const &) = delete;
+
+        id_t                    f_id = id_t();
+        void *                  f_data = nullptr;
+        std::size_t             f_size = 0;
+    };
+
+    class face
+    {
+    public:
+        typedef std::shared_ptr<face>   pointer_t;
+
+                                face(
+                                      std::string const & filename
+                                    , FT_Long face_index
+                                    , file_mapping::pointer_t mapping);
+                                face(face const &) = delete;
+                                ~face();
+        face &                  operator = (face const &) = delete;
+
+        FT_Face                 get_face() const;
+        std::mutex &            get_mutex();
+        FT_MM_Var const *       get_variations() const;
+        std::vector<FT_Fixed> & get_coordinates();
+
+    private:
+        file_mapping::pointer_t f_mapping = file_mapping::pointer_t();
+        FT_Face                 f_face = FT_Face();
+        std::mutex              f_mutex = std::mutex();
+        FT_MM_Var *             f_variations = nullptr;
+        std::vector<FT_Fixed>   f_coordinates = std::vector<FT_Fixed>();
+    };
+
+    static pointer_t        get_instance();
+
+    face::pointer_t         get_face(std::string const & filename, FT_Long face_index);
+    void                    set_max_idle_faces(std::size_t max_idle_faces);
+    void                    close_idle_faces();
+
+private:
+    struct entry
+    {
+        face::pointer_t     f_face = face::pointer_t();
+        std::size_t         f_users = 0;
+        std::list<std::string>::iterator
+                            f_idle = std::list<std::string>::iterator();
+    };
+
+                            face_registry() = default;
+
+    void                    release(std::string const & key);
+    void                    trim_idle_faces(std::size_t max_idle_faces);
+
+    std::mutex              f_mutex = std::mutex();
+    std::map<file_mapping::id_t, std::weak_ptr<file_mapping>>
+                            f_files = std::map<file_mapping::id_t, std::weak_ptr<file_mapping>>();
+    std::map<std::string, entry>
+                            f_faces = std::map<std::string, entry>();
+    std::list<std::string>  f_idle_faces = std::list<std::string>();
+    std::size_t             f_max_idle_faces = DEFAULT_MAX_IDLE_FACES;
+};
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -28,7 +28,12 @@
 //
 #include    "ftmesh/font.h"
 
+#include    "ftmesh/code_point_reader.h"
+#include    "ftmesh/face_registry.h"
+#include    "ftmesh/outline_cache.h"
 #include    "ftmesh/polygon.h"
+#include    "ftmesh/shared_cache.h"
+#include    "ftmesh/string_cache.h"
 
 
 // snapdev
@@ -38,6 +43,8 @@
 
 // libutf8
 //
+#include    <libutf8/base.h>
+#include    <libutf8/exception.h>
 #include    <libutf8/libutf8.h>
 
 
@@ -57,13 +64,35 @@
 #include    <ft2build.h>
 
 #include    FT_FREETYPE_H
+#include    FT_FONT_FORMATS_H
 #include    FT_GLYPH_H
+#include    FT_MULTIPLE_MASTERS_H
 #include    FT_OUTLINE_H
+#include    FT_SFNT_NAMES_H
+#include    FT_SIZES_H
+#include    FT_TRUETYPE_IDS_H
+
+
+#ifdef FTMESH_HARFBUZZ
+// HarfBuzz
+//
+#include    <hb.h>
+#include    <hb-ft.h>
+#endif
 
 
 // C++
 //
+#include    <algorithm>
+#include    <atomic>
+#include    <cmath>
+#include    <condition_variable>
+#include    <deque>
 #include    <iostream>
+#include    <mutex>
+#include    <set>
+#include    <thread>
+#include    <unordered_map>
 
 
 // last include
@@ -73,55 +102,81 @@
 
 
 
-
-FT_Library  g_ft_library;
-
-
 namespace ftmesh
 {
 
 
-namespace
+namespace detail
 {
 
 
-constexpr FT_Long const DEFAULT_FACE_INDEX = 0;
-
+#ifdef FTMESH_HARFBUZZ
+namespace
+{
 
 
-class auto_init_freetype_library
+/** \brief Buffer reused by all the shaping calls of one thread.
+ *
+ * A HarfBuzz buffer grows to fit the largest string it shaped. Keeping
+ * one per thread avoids allocating a new buffer for each string without
+ * having to lock it.
+ */
+class hb_buffer_holder
 {
 public:
-    auto_init_freetype_library()
+    hb_buffer_holder() = default;
+    hb_buffer_holder(hb_buffer_holder const &) = delete;
+    hb_buffer_holder & operator = (hb_buffer_holder const &) = delete;
+
+    ~hb_buffer_holder()
     {
-        int e(FT_Init_FreeType(&g_ft_library));
-        if(e != 0)
+        if(f_buffer != nullptr)
         {
-            SNAP_LOG_ERROR
-                << "An error occurred initializing the FreeType library ("
-                << e
-                << ")"
-                << SNAP_LOG_SEND;
+            hb_buffer_destroy(f_buffer);
         }
     }
-};
 
-auto_init_freetype_library       g_auto_init_freetype_library = auto_init_freetype_library();
+    hb_buffer_t * get()
+    {
+        if(f_buffer == nullptr)
+        {
+            f_buffer = hb_buffer_create();
+        }
+        else
+        {
+            hb_buffer_clear_contents(f_buffer);
+        }
+        return f_buffer;
+    }
+
+private:
+    hb_buffer_t *   f_buffer = nullptr;
+};
 
 
+thread_local hb_buffer_holder   g_hb_buffer = hb_buffer_holder();
 
 
 } // no name namespace
+#endif
 
 
-namespace detail
-{
-
 
 //////////////
 // font_impl
 
 
+// same limit as FreeType's TT_MAX_COMPOSITE_RECURSE
+//
+constexpr std::size_t const MAX_COMPOSITE_DEPTH = 5;
+
+
+// a text using many different pairs would otherwise grow the kerning
+// map forever; when full, the map is cleared and refilled on demand
+//
+constexpr std::size_t const MAX_KERNING_PAIRS = 16 * 1024;
+
+
 // in order to hide all the FreeType headers, we use an internal implementation
 //
 class font_impl
@@ -129,17 +184,87 @@ class font_impl
 public:
     typedef std::shared_ptr<font_impl>
                             pointer_t;
-
-                            font_impl(std::string const & filename);
+    typedef std::map<FT_UInt, mesh::pointer_t>
+                            index_map_t;
+    typedef std::map<char32_t, std::promise<mesh::pointer_t>>
+                            promise_map_t;
+    typedef std::map<char32_t, std::shared_future<mesh::pointer_t>>
+                            future_map_t;
+    typedef std::unordered_map<std::uint64_t, float>
+                            kerning_map_t;
+    typedef std::pair<char32_t, char32_t>
+                            kerning_pair_t;
+#ifdef FTMESH_HARFBUZZ
+    typedef std::map<std::string, hb_shape_plan_t *>
+                            shape_plan_map_t;
+#endif
+
+    // the meshes depend on the variation coordinates and the synthetic
+    // styles, each variant gets its own maps
+    //
+    struct variant_cache
+    {
+        index_map_t         f_index_map = index_map_t();
+        index_map_t         f_placeholder_map = index_map_t();
+        kerning_map_t       f_index_kerning_map = kerning_map_t();
+#ifdef FTMESH_HARFBUZZ
+        shape_plan_map_t    f_shape_plans = shape_plan_map_t();
+#endif
+        slab::pointer_t     f_slab = slab::pointer_t();
+        std::uint64_t       f_last_used = 0;
+    };
+    typedef std::map<std::string, variant_cache>
+                            variant_cache_map_t;
+
+                            font_impl(
+                                      std::string const & filename
+                                    , int face_index
+                                    , open_mode_t mode);
                             font_impl(font_impl const &) = delete;
                             ~font_impl();
     font_impl &             operator = (font_impl const &) = delete;
 
+    bool                    is_open() const;
     mesh::pointer_t         get_mesh(char32_t glyph);
+    mesh::pointer_t         get_mesh_by_glyph_index(FT_UInt index);
+    mesh::pointer_t         find_mesh(char32_t glyph);
+    std::shared_future<mesh::pointer_t>
+                            get_mesh_async(char32_t glyph);
+    void                    set_mesh_ready_callback(font::mesh_ready_t callback);
+    void                    prewarm_kerning(char32_t current_char, char32_t next_char);
     void                    set_precision(int precision);
     bool                    has_kerning_table() const;
     void                    set_size(int point_size, int x_resolution, int y_resolution);
+    void                    set_simplify_tolerance(double tolerance);
+    void                    set_mesh_format(mesh_format_t format);
+    void                    set_reuse_composites(bool reuse);
+    void                    set_slab_storage(bool use_slab);
+    slab::pointer_t         get_slab();
+    void                    set_shared_cache(std::string const & name, std::size_t size);
+    void                    set_outline_cache(outline_cache::pointer_t cache);
+    std::string             build_settings_key() const;
+    std::string const &     get_settings_key();
+    std::string_view        get_string_key(std::string_view message);
+    std::string_view        get_string_key(std::u32string_view message);
+    string_cache &          get_string_cache();
+    glyph_pool::pointer_t   get_glyph_pool();
     float                   get_kerning(char32_t current_char, char32_t next_char);
+    float                   get_kerning_by_index(FT_UInt current_index, FT_UInt next_index);
+    shaped_glyph::vector_t  shape(std::u32string_view text);
+    float                   get_line_height();
+    std::u32string          get_characters();
+    variation_axis::vector_t
+                            get_variation_axes();
+    named_instance::vector_t
+                            get_named_instances();
+    bool                    set_variation(std::vector<double> const & coordinates);
+    std::vector<double>     get_variation();
+    void                    set_variation_step(double step);
+    void                    set_snap_to_named_instances(bool snap);
+    bool                    set_synthetic_bold(double strength);
+    bool                    set_synthetic_oblique(double slant);
+    bool                    set_load_flags(load_flags_t flags);
+    load_flags_t            get_load_flags() const;
 
 private:
     // WARNING: the callback parameters are not what is defined in the
@@ -159,6 +284,35 @@ private:
     static void             tess_callback_end(font_impl * impl);
     static void             tess_callback_error(GLenum errCode, font_impl * impl);
 
+    void                    open();
+    std::unique_lock<std::mutex>
+                            lock_face();
+    std::unique_lock<std::mutex>
+                            lock_settings();
+    void                    apply_size();
+    void                    apply_coordinates();
+    std::string             get_variant_key() const;
+    FT_Int32                get_freetype_load_flags() const;
+    void                    select_variant();
+    void                    apply_synthetic_style();
+    std::string             get_name(FT_UInt name_id) const;
+    mesh::pointer_t         get_shared_mesh(FT_UInt index);
+    mesh::pointer_t         get_mesh_by_index(FT_UInt index);
+    mesh::pointer_t         get_placeholder(FT_UInt index);
+    float                   get_cached_kerning(FT_UInt current_index, FT_UInt next_index);
+    float                   load_kerning(FT_UInt current_index, FT_UInt next_index);
+    FT_Pos                  get_synthetic_bold_strength() const;
+    shaped_glyph::vector_t  shape_with_kerning(std::u32string_view text);
+#ifdef FTMESH_HARFBUZZ
+    hb_shape_plan_t *       get_shape_plan(hb_segment_properties_t const & properties);
+    static void             destroy_shape_plans(variant_cache & cache);
+#endif
+    void                    start_worker();
+    void                    worker();
+    outline_cache::key      get_outline_key() const;
+    mesh::pointer_t         load_composite(FT_UInt index);
+    mesh::pointer_t         load_mesh(FT_UInt index);
+
     void                    callback_begin();
     void                    callback_vertex(point const & p);
     point::pointer_t        callback_combine(point const & p);
@@ -166,491 +320,3706 @@ private:
     void                    callback_error(GLenum errCode);
 
     std::string const       f_filename = std::string();
+    FT_Long const           f_face_index = DEFAULT_FACE_INDEX;
+    face_registry::face::pointer_t
+                            f_shared_face = face_registry::face::pointer_t();
     FT_Face                 f_face = FT_Face();
+    std::mutex *            f_mutex = nullptr;
+    FT_Size                 f_size = FT_Size();
+    std::mutex              f_open_mutex = std::mutex();
+    std::atomic<bool>       f_open = false;
+    std::thread             f_prefetch = std::thread();
+    bool                    f_size_dirty = true;
     mesh::pointer_t         f_current_mesh = mesh::pointer_t();
     int                     f_precision = DEFAULT_UPSCALE;
+    int                     f_point_size = DEFAULT_SIZE;
+    int                     f_x_resolution = DEFAULT_RESOLUTION;
+    int                     f_y_resolution = DEFAULT_RESOLUTION;
+    double                  f_simplify_tolerance = DEFAULT_SIMPLIFY_TOLERANCE;
+    mesh_format_t           f_mesh_format = mesh_format_t::MESH_FORMAT_TRIANGLES;
+    bool                    f_truetype = false;
+    bool                    f_reuse_composites = false;
+    std::set<FT_UInt>       f_loading_composites = std::set<FT_UInt>();
+    bool                    f_use_slab = false;
+    std::vector<FT_Fixed>   f_coordinates = std::vector<FT_Fixed>();
+    double                  f_variation_step = DEFAULT_VARIATION_STEP;
+    bool                    f_snap_to_named_instances = false;
+    double                  f_synthetic_bold = 0.0;
+    double                  f_synthetic_oblique = 0.0;
+    load_flags_t            f_load_flags = LOAD_FLAG_DEFAULT;
+#ifdef FTMESH_HARFBUZZ
+    hb_font_t *             f_hb_font = nullptr;
+#endif
+    variant_cache_map_t     f_variant_caches = variant_cache_map_t();
+    std::uint64_t           f_variant_clock = 0;
+    variant_cache *         f_cache = nullptr;
+    outline_cache::pointer_t
+                            f_outline_cache = std::make_shared<outline_cache>();
+    std::string             f_settings_key = std::string();
+    std::string             f_string_key = std::string();
+    glyph_pool::pointer_t   f_glyph_pool = glyph_pool::pointer_t();
+    std::string             f_glyph_pool_key = std::string();
+    shared_cache::pointer_t f_shared_cache = shared_cache::pointer_t();
+    std::mutex              f_queue_mutex = std::mutex();
+    std::condition_variable f_queue_condition = std::condition_variable();
+    std::deque<char32_t>    f_queue = std::deque<char32_t>();
+    std::deque<kerning_pair_t>
+                            f_kerning_queue = std::deque<kerning_pair_t>();
+    promise_map_t           f_promises = promise_map_t();
+    future_map_t            f_futures = future_map_t();
+    font::mesh_ready_t      f_mesh_ready_callback = font::mesh_ready_t();
+    bool                    f_stop = false;
+    std::thread             f_worker = std::thread();
+    string_cache            f_string_cache = string_cache();
     std::size_t             f_temporary_vertex_pos = 0;
     point::safe_vector_t    f_temporary_vertex = point::safe_vector_t();       
 };
 
 
-font_impl::font_impl(std::string const & font)
+/** \brief Prepare a font.
+ *
+ * With open_mode_t::OPEN_MODE_IMMEDIATE, the face is opened right away
+ * (see open()). With the other modes, the constructor only saves the
+ * filename. The face gets opened the first time it is needed, either
+ * by the caller or, with open_mode_t::OPEN_MODE_PREFETCH, by a thread
+ * started here.
+ *
+ * \exception std::runtime_error
+ * In immediate mode, the file could not be opened or is not a supported
+ * font. In the other modes, that error is raised by the first function
+ * which needs the face instead.
+ *
+ * \exception std::out_of_range
+ * The \p face_index is negative.
+ *
+ * \param[in] font  The name of the font file.
+ * \param[in] face_index  The index of the face in a font collection.
+ * \param[in] mode  When to open the font.
+ */
+font_impl::font_impl(std::string const & font, int face_index, open_mode_t mode)
     : f_filename(font)
+    , f_face_index(face_index)
+    , f_cache(&f_variant_caches[get_variant_key()])
 {
-    FT_Error e(FT_New_Face(
-              g_ft_library
-            , f_filename.c_str()
-            , DEFAULT_FACE_INDEX
-            , &f_face));
-    if(e != FT_Err_Ok)
+    if(face_index < 0)
     {
-        throw std::runtime_error(
-                  "FT_New_Face() could not load \""
+        throw std::out_of_range(
+                  "the face index of \""
                 + f_filename
-                + "\" (FT_Error: "
-                + std::to_string(e)
+                + "\" cannot be negative ("
+                + std::to_string(face_index)
                 + ")");
     }
 
-    e = FT_Select_Charmap(f_face, FT_ENCODING_UNICODE);
-    if(e != FT_Err_Ok)
+    switch(mode)
     {
-        throw std::runtime_error(
-                  "FT_New_Face() could not set Unicode Charmap for \""
-                + f_filename
-                + "\" (FT_Error: "
-                + std::to_string(e)
-                + ")");
-    }
+    case open_mode_t::OPEN_MODE_IMMEDIATE:
+        // this also applies the default size
+        //
+        lock_face();
+        break;
 
-    // make sure to define a default size which is always the same
-    //
-    set_size(DEFAULT_SIZE, DEFAULT_RESOLUTION, DEFAULT_RESOLUTION);
-}
+    case open_mode_t::OPEN_MODE_LAZY:
+        break;
 
+    case open_mode_t::OPEN_MODE_PREFETCH:
+        f_prefetch = std::thread([this]()
+            {
+                try
+                {
+                    open();
+                }
+                catch(std::exception const &)
+                {
+                    // the face remains closed so the error gets raised
+                    // again when the face is actually needed
+                }
+            });
+        break;
 
-font_impl::~font_impl()
-{
-    FT_Done_Face(f_face);
+    }
 }
 
 
-mesh::pointer_t font_impl::get_mesh(char32_t glyph)
+font_impl::~font_impl()
 {
-    FT_UInt const index(FT_Get_Char_Index(f_face, glyph));
-    int const e(FT_Load_Glyph(f_face, index, FT_LOAD_DEFAULT));
-    if(e != FT_Err_Ok
-    || f_face->glyph == nullptr)     // the load failed
+    if(f_prefetch.joinable())
     {
-        return mesh::pointer_t();
+        f_prefetch.join();
     }
 
-    if(f_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+    if(f_worker.joinable())
     {
-        // valid load, not a valid format, we expected vertices (an outline)
+        {
+            std::lock_guard<std::mutex> lock(f_queue_mutex);
+            f_stop = true;
+        }
+        f_queue_condition.notify_all();
+        f_worker.join();
+
+        // the glyphs still in the queue will never be generated, make
+        // sure their futures do not wait forever
         //
-        return mesh::pointer_t();
+        for(auto & p : f_promises)
+        {
+            p.second.set_exception(std::make_exception_ptr(std::runtime_error(
+                      "font destroyed before the mesh of character "
+                    + std::to_string(static_cast<std::uint32_t>(p.first))
+                    + " was generated")));
+        }
     }
 
-    int start_index(0);
-    int end_index(0);
-
-    polygon::vector_t polygons(f_face->glyph->outline.n_contours);
-
-    for(std::size_t i(0); i < polygons.size(); ++i)
+    if(f_size != nullptr)
     {
-        end_index = f_face->glyph->outline.contours[i] + 1;
+        std::lock_guard<std::mutex> lock(*f_mutex);
+#ifdef FTMESH_HARFBUZZ
+        for(auto & c : f_variant_caches)
+        {
+            destroy_shape_plans(c.second);
+        }
+        if(f_hb_font != nullptr)
+        {
+            hb_font_destroy(f_hb_font);
+        }
+#endif
+        FT_Done_Size(f_size);
+    }
+}
 
-        polygons[i] = std::make_shared<polygon>(
-                                  f_face->glyph->outline.points + start_index
-                                , reinterpret_cast<char *>(f_face->glyph->outline.tags) + start_index
-                                , end_index - start_index);
 
-        start_index = end_index;
+/** \brief Open the face.
+ *
+ * The face is shared with all the other fonts opening the same file
+ * (see face_registry). This font gets its own FT_Size so its size
+ * settings do not affect the other fonts.
+ *
+ * If the face is already open, this function does nothing. It does not read
+ * the settings since the caller may be changing them at the same time
+ * when the face is opened by the prefetch thread. The size gets applied
+ * by lock_face() instead.
+ *
+ * \exception std::runtime_error
+ * The file could not be opened or is not a supported font.
+ */
+void font_impl::open()
+{
+    if(is_open())
+    {
+        return;
     }
 
-    // compute the parity of each polygon
-    //
-    // FIXME: see whether FT_Outline_Get_Orientation can do it for us.
+    // a failure leaves the face closed so the next call tries again
     //
-    for(std::size_t i(0); i < polygons.size(); ++i)
+    std::lock_guard<std::mutex> open_lock(f_open_mutex);
+    if(is_open())
     {
-        polygon::pointer_t c1(polygons[i]);
-        point const leftmost(c1->leftmost());
-        int parity(0);
-        for(std::size_t j(0); j < polygons.size(); ++j)
-        {
-            if(j == i)
-            {
-                continue;
-            }
+        return;
+    }
 
-            polygon::pointer_t c2(polygons[j]);
-            for(size_t n(0); n < c2->size(); ++n)
-            {
-                point const p1(c2->at(n));
-                point const p2(c2->at(n + 1));
+    face_registry::face::pointer_t shared_face(face_registry::get_instance()->get_face(f_filename, f_face_index));
+    FT_Face face(shared_face->get_face());
+    std::mutex & m(shared_face->get_mutex());
 
-                /* FIXME: combinations of >= > <= and < do not seem stable */
-                if((p1.y() <  leftmost.y() && p2.y() <  leftmost.y())
-                || (p1.y() >= leftmost.y() && p2.y() >= leftmost.y())
-                || (p1.x() >  leftmost.x() && p2.x() >  leftmost.x()))
-                {
-                    ;
-                }
-                else if(p1.x() < leftmost.x()
-                     && p2.x() < leftmost.x())
-                {
-                    parity++;
-                }
-                else
-                {
-                    point const a(p1 - leftmost);
-                    point const b(p2 - leftmost);
-                    if(b.x() * a.y() > b.y() * a.x())
-                    {
-                        parity++;
-                    }
-                }
-            }
+    FT_Size size(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(m);
+        FT_Error const e(FT_New_Size(face, &size));
+        if(e != FT_Err_Ok)
+        {
+            throw std::runtime_error(
+                      "FT_New_Size() failed for \""
+                    + f_filename
+                    + "\" (FT_Error: "
+                    + std::to_string(e)
+                    + ")");
         }
-
-        c1->apply_parity(parity);
     }
 
-    f_current_mesh = std::make_shared<mesh>(static_cast<float>(f_face->glyph->advance.x) / static_cast<float>(f_precision));
-    f_temporary_vertex_pos = 0;
+    f_shared_face = shared_face;
+    f_face = face;
+    f_mutex = &m;
+    f_size = size;
 
-    GLUtesselator * tobj(gluNewTess());
+    // the FT_LOAD_NO_RECURSE flag is only supported by TrueType fonts
+    //
+    char const * format(FT_Get_Font_Format(f_face));
+    f_truetype = format != nullptr && std::string(format) == "TrueType";
 
-    gluTessCallback(tobj, GLU_TESS_EDGE_FLAG_DATA, reinterpret_cast<_GLUfuncptr>(&tess_callback_edge));
-    gluTessCallback(tobj, GLU_TESS_BEGIN_DATA,     reinterpret_cast<_GLUfuncptr>(&tess_callback_begin));
-    gluTessCallback(tobj, GLU_TESS_VERTEX_DATA,    reinterpret_cast<_GLUfuncptr>(&tess_callback_vertex));
-    gluTessCallback(tobj, GLU_TESS_COMBINE_DATA,   reinterpret_cast<_GLUfuncptr>(&tess_callback_combine));
-    gluTessCallback(tobj, GLU_TESS_END_DATA,       reinterpret_cast<_GLUfuncptr>(&tess_callback_end));
-    gluTessCallback(tobj, GLU_TESS_ERROR_DATA,     reinterpret_cast<_GLUfuncptr>(&tess_callback_error));
+    f_open.store(true, std::memory_order_release);
+}
 
-    if((f_face->glyph->outline.flags & FT_OUTLINE_EVEN_ODD_FILL) != 0) // ft_outline_reverse_fill
+
+/** \brief Check whether the face was opened.
+ *
+ * \return true once the face is open.
+ */
+bool font_impl::is_open() const
+{
+    return f_open.load(std::memory_order_acquire);
+}
+
+
+/** \brief Lock the face, opening it first if necessary.
+ *
+ * The face is shared with other fonts so this function locks its mutex
+ * and makes our size the active one. If the size was changed since it
+ * was last applied, it gets applied now.
+ *
+ * \exception std::runtime_error
+ * The face could not be opened.
+ *
+ * \return The lock on the face mutex.
+ */
+std::unique_lock<std::mutex> font_impl::lock_face()
+{
+    open();
+
+    std::unique_lock<std::mutex> lock(*f_mutex);
+    FT_Activate_Size(f_size);
+    apply_coordinates();
+    if(f_size_dirty)
     {
-        gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_ODD);
+        apply_size();
     }
-    else
+    return lock;
+}
+
+
+/** \brief Lock the face before changing a setting.
+ *
+ * Once the face is open, the background worker may be using the
+ * settings so the face gets locked. Before that, the settings are only
+ * used by the caller and the face remains closed: changing the settings
+ * of a lazy font does not open it.
+ *
+ * \return The lock on the face mutex or an empty lock.
+ */
+std::unique_lock<std::mutex> font_impl::lock_settings()
+{
+    if(!is_open())
     {
-        gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
+        return std::unique_lock<std::mutex>();
     }
+    return lock_face();
+}
 
-    gluTessProperty(tobj, GLU_TESS_BOUNDARY_ONLY, GLU_FALSE);
-    gluTessProperty(tobj, GLU_TESS_TOLERANCE, 0.0);
-    gluTessNormal(tobj, 0.0, 0.0, 1.0);
-
-    gluTessBeginPolygon(tobj, this);
 
-        for(std::size_t c(0); c < polygons.size(); ++c)
-        {
-            gluTessBeginContour(tobj);
+mesh::pointer_t font_impl::get_mesh(char32_t glyph)
+{
+    std::unique_lock<std::mutex> lock(lock_face());
 
-                polygon::pointer_t polygon(polygons[c]);
-                for(std::size_t p(0); p < polygon->size(); ++p)
-                {
-                    gluTessVertex(
-                          tobj
-                        , const_cast<double *>(polygon->at(p).f_coordinates)
-                        , const_cast<double *>(polygon->at(p).f_coordinates));
-                }
+    return get_shared_mesh(FT_Get_Char_Index(f_face, glyph));
+}
 
-            gluTessEndContour(tobj);
-        }
 
-    gluTessEndPolygon(tobj);
+/** \brief Get the mesh of a glyph from its index.
+ *
+ * This is the same as get_mesh() for callers which already know the
+ * glyph index (i.e. they shaped the text). The meshes are shared with
+ * get_mesh().
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The mesh of that glyph or nullptr if it can't be loaded.
+ */
+mesh::pointer_t font_impl::get_mesh_by_glyph_index(FT_UInt index)
+{
+    std::unique_lock<std::mutex> lock(lock_face());
 
-    gluDeleteTess(tobj);
+    if(index >= static_cast<FT_UInt>(f_face->num_glyphs))
+    {
+        return mesh::pointer_t();
+    }
 
-    mesh::pointer_t result;
-    f_current_mesh.swap(result);
-    return result;
+    return get_shared_mesh(index);
 }
 
 
-void font_impl::set_precision(int precision)
+/** \brief Get a mesh from the shared cache or generate it.
+ *
+ * When a shared cache is defined, another process may already have
+ * generated this mesh. Otherwise, or if not found there, the mesh is
+ * generated and published.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The mesh of that glyph or nullptr if it can't be loaded.
+ */
+mesh::pointer_t font_impl::get_shared_mesh(FT_UInt index)
 {
-    if(precision <= 0)
+    if(f_shared_cache == nullptr
+    || f_cache->f_index_map.find(index) != f_cache->f_index_map.end())
     {
-        throw std::runtime_error("the precision must be positive");
+        return get_mesh_by_index(index);
     }
 
-    f_precision = precision;
+    std::string const key(
+                  f_filename
+                + ':' + std::to_string(f_face_index)
+                + '\n' + build_settings_key()
+                + std::to_string(index));
+    mesh::pointer_t result(f_shared_cache->find(key, get_slab()));
+    if(result != nullptr)
+    {
+        f_cache->f_index_map[index] = result;
+        f_cache->f_placeholder_map.erase(index);
+        return result;
+    }
 
-    // TBD: should we call the set_size() funciton? if we want to be able to
-    // do that, we need to save the point and resolution parameters...
+    result = get_mesh_by_index(index);
+    if(result != nullptr)
+    {
+        f_shared_cache->publish(key, result);
+    }
+    return result;
 }
 
 
-bool font_impl::has_kerning_table() const
+/** \brief Get a mesh without waiting for its tessellation.
+ *
+ * If the mesh of \p glyph was already generated, it gets returned.
+ * Otherwise its generation is queued to the background worker and a
+ * placeholder is returned instead (see get_placeholder()).
+ *
+ * \param[in] glyph  The character to retrieve.
+ *
+ * \return The mesh, a placeholder, or nullptr if the glyph does not
+ * exist.
+ */
+mesh::pointer_t font_impl::find_mesh(char32_t glyph)
 {
-    return FT_HAS_KERNING(f_face) != 0; 
+    mesh::pointer_t placeholder;
+    {
+        std::unique_lock<std::mutex> lock(lock_face());
+        FT_UInt const index(FT_Get_Char_Index(f_face, glyph));
+        auto it(f_cache->f_index_map.find(index));
+        if(it != f_cache->f_index_map.end())
+        {
+            return it->second;
+        }
+        placeholder = get_placeholder(index);
+        if(placeholder == nullptr)
+        {
+            return placeholder;
+        }
+    }
+
+    get_mesh_async(glyph);
+
+    return placeholder;
 }
 
 
-/** \brief Set the size of the font.
- *
- * This function sets the size of the font. You must have called the
- * set_precision() function first if you want your new precision to work.
+/** \brief Queue the generation of a mesh.
  *
- * The \p point_size is the usual \em point definition. More or less, the
- * height, knowing that it is not going to match the pixel height.
+ * The mesh gets generated by a background thread so the caller does not
+ * block while the glyph gets tessellated. The thread is started the
+ * first time this function is called.
  *
- * \note
- * The constructor calls this function once with:
+ * If the mesh is already available, the returned future is ready
+ * immediately. Requesting the same glyph several times before it is
+ * ready returns the same future.
  *
- * \code
- *     set_size(DEFAULT_SIZE, DEFAULT_RESOLUTION, DEFAULT_RESOLUTION);
- * \endcode
+ * If the font gets destroyed before the glyph was generated, the future
+ * holds a std::runtime_error.
  *
- * \warning
- * It is important to call this function BEFORE you ever call the get_mesh()
- * or convert_string(). Also, calling this function AFTER will not work as
- * expected (i.e. it doesn't dynamically reset all the existing glyph and
- * restart with the new size). In a future version, we may fix this issue.
+ * \param[in] glyph  The character to generate.
  *
- * \param[in] point_size  The font height to use.
- * \param[in] x_resolution  The horizontal resolution, 72 by default.
- * \param[in] y_resolution  The vertical resolution, 72 by default.
+ * \return A future which will hold the mesh.
+ */
+std::shared_future<mesh::pointer_t> font_impl::get_mesh_async(char32_t glyph)
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_face());
+        auto it(f_cache->f_index_map.find(FT_Get_Char_Index(f_face, glyph)));
+        if(it != f_cache->f_index_map.end())
+        {
+            std::promise<mesh::pointer_t> ready;
+            ready.set_value(it->second);
+            return ready.get_future().share();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(f_queue_mutex);
+
+    auto it(f_futures.find(glyph));
+    if(it != f_futures.end())
+    {
+        return it->second;
+    }
+
+    std::promise<mesh::pointer_t> & promise(f_promises[glyph]);
+    std::shared_future<mesh::pointer_t> result(promise.get_future().share());
+    f_futures[glyph] = result;
+    f_queue.push_back(glyph);
+    start_worker();
+
+    return result;
+}
+
+
+/** \brief Queue the computation of a kerning pair.
+ *
+ * The background worker computes the kerning of the pair and saves it
+ * in the kerning cache. The glyphs queued with get_mesh_async() are
+ * processed first.
+ *
+ * \param[in] current_char  The character on the left.
+ * \param[in] next_char  The character on the right.
+ */
+void font_impl::prewarm_kerning(char32_t current_char, char32_t next_char)
+{
+    std::lock_guard<std::mutex> lock(f_queue_mutex);
+    f_kerning_queue.emplace_back(current_char, next_char);
+    start_worker();
+}
+
+
+/** \brief Start the worker thread if not yet running and wake it up.
+ *
+ * The caller must hold f_queue_mutex.
+ */
+void font_impl::start_worker()
+{
+    if(!f_worker.joinable())
+    {
+        f_worker = std::thread(&font_impl::worker, this);
+    }
+    f_queue_condition.notify_one();
+}
+
+
+/** \brief Set the function called when a background mesh is ready.
+ *
+ * \warning
+ * The callback is called from the worker thread, before the future
+ * returned by get_mesh_async() becomes ready.
+ *
+ * \param[in] callback  The function to call with each new mesh.
+ */
+void font_impl::set_mesh_ready_callback(font::mesh_ready_t callback)
+{
+    std::lock_guard<std::mutex> lock(f_queue_mutex);
+    f_mesh_ready_callback = callback;
+}
+
+
+/** \brief Generate the queued meshes.
+ *
+ * This function runs in the background thread. It generates the meshes
+ * one at a time, so the f_mutex is released between glyphs and the
+ * other threads do not wait for more than one glyph.
+ */
+void font_impl::worker()
+{
+    for(;;)
+    {
+        char32_t glyph(U'\0');
+        {
+            std::unique_lock<std::mutex> lock(f_queue_mutex);
+            f_queue_condition.wait(lock, [this]()
+                {
+                    return f_stop
+                        || !f_queue.empty()
+                        || !f_kerning_queue.empty();
+                });
+            if(f_stop)
+            {
+                return;
+            }
+            if(f_queue.empty())
+            {
+                kerning_pair_t const pair(f_kerning_queue.front());
+                f_kerning_queue.pop_front();
+                lock.unlock();
+
+                try
+                {
+                    get_kerning(pair.first, pair.second);
+                }
+                catch(...)
+                {
+                    // the pair is only prewarmed, the error gets raised
+                    // again when the kerning is actually needed
+                }
+                continue;
+            }
+            glyph = f_queue.front();
+            f_queue.pop_front();
+        }
+
+        mesh::pointer_t m;
+        std::exception_ptr error;
+        try
+        {
+            m = get_mesh(glyph);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        std::promise<mesh::pointer_t> promise;
+        font::mesh_ready_t callback;
+        {
+            std::lock_guard<std::mutex> lock(f_queue_mutex);
+            promise = std::move(f_promises[glyph]);
+            f_promises.erase(glyph);
+            f_futures.erase(glyph);
+            callback = f_mesh_ready_callback;
+        }
+
+        if(error != nullptr)
+        {
+            promise.set_exception(error);
+            continue;
+        }
+        if(callback != nullptr)
+        {
+            callback(glyph, m);
+        }
+        promise.set_value(m);
+    }
+}
+
+
+/** \brief Get the mesh of a glyph by index.
+ *
+ * Several code points often map to the same glyph (i.e. all the missing
+ * characters use glyph 0, compatibility characters, etc.) and the
+ * components of composite glyphs are referenced by index. The meshes
+ * are therefore cached by glyph index so each glyph gets tessellated
+ * only once.
+ *
+ * The components are loaded with FT_LOAD_NO_RECURSE which turns off
+ * the recursion limit of FreeType. A composite referencing itself,
+ * directly or not, or nested too deeply is instead loaded flattened by
+ * FreeType, which detects such errors.
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The mesh of that glyph or nullptr if it can't be loaded.
+ */
+mesh::pointer_t font_impl::get_mesh_by_index(FT_UInt index)
+{
+    auto it(f_cache->f_index_map.find(index));
+    if(it != f_cache->f_index_map.end())
+    {
+        return it->second;
+    }
+
+    // the synthetic styles need the flattened outline
+    //
+    mesh::pointer_t result;
+    if(f_reuse_composites
+    && f_truetype
+    && f_synthetic_bold == 0.0
+    && f_synthetic_oblique == 0.0
+    && f_loading_composites.size() < MAX_COMPOSITE_DEPTH
+    && f_loading_composites.insert(index).second)
+    {
+        try
+        {
+            result = load_composite(index);
+        }
+        catch(...)
+        {
+            f_loading_composites.erase(index);
+            throw;
+        }
+        f_loading_composites.erase(index);
+    }
+    if(result == nullptr)
+    {
+        result = load_mesh(index);
+    }
+    f_cache->f_index_map[index] = result;
+
+    // the placeholder is not returned anymore once the mesh is available
+    //
+    f_cache->f_placeholder_map.erase(index);
+
+    return result;
+}
+
+
+/** \brief Get a quad covering the glyph.
+ *
+ * Loading the metrics of a glyph is fast compared to tessellating its
+ * outline. This function creates a mesh with two triangles covering
+ * the bounding box of the glyph with the correct advance and bearings.
+ * It is used in place of the real mesh until the background worker
+ * generated it. Glyphs without ink (i.e. a space) get an empty mesh.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The placeholder mesh or nullptr if the glyph can't be loaded.
+ */
+mesh::pointer_t font_impl::get_placeholder(FT_UInt index)
+{
+    auto it(f_cache->f_placeholder_map.find(index));
+    if(it != f_cache->f_placeholder_map.end())
+    {
+        return it->second;
+    }
+
+    mesh::pointer_t result;
+    int const e(FT_Load_Glyph(f_face, index, get_freetype_load_flags()));
+    if(e == FT_Err_Ok)
+    {
+        apply_synthetic_style();
+
+        float const precision(static_cast<float>(f_precision));
+        FT_Glyph_Metrics const & metrics(f_face->glyph->metrics);
+        result = std::make_shared<mesh>(static_cast<float>(f_face->glyph->advance.x) / precision);
+        result->set_bearing(
+                  static_cast<float>(metrics.horiBearingX) / precision
+                , static_cast<float>(metrics.horiBearingY) / precision);
+        result->set_placeholder(true);
+
+        if(metrics.width > 0
+        && metrics.height > 0)
+        {
+            double const left(static_cast<double>(metrics.horiBearingX) / f_precision);
+            double const top(static_cast<double>(metrics.horiBearingY) / f_precision);
+            double const right(left + static_cast<double>(metrics.width) / f_precision);
+            double const bottom(top - static_cast<double>(metrics.height) / f_precision);
+            result->begin();
+            result->add_point(point(left, bottom));
+            result->add_point(point(right, bottom));
+            result->add_point(point(left, top));
+            result->add_point(point(right, bottom));
+            result->add_point(point(right, top));
+            result->add_point(point(left, top));
+            result->end();
+            result->optimize(f_mesh_format);
+        }
+    }
+    f_cache->f_placeholder_map[index] = result;
+
+    return result;
+}
+
+
+/** \brief Generate a key representing the outline in the glyph slot.
+ *
+ * Different glyph indexes may still have the exact same outline (i.e.
+ * fullwidth forms or duplicated glyphs in large CJK fonts). The key
+ * is a hash of everything used to generate a mesh: the settings,
+ * advance, bearings, contours, points and tags. The advance and the
+ * number of contours and points are also saved as is in the key so a
+ * hash collision also requires those to be equal. It is used as the
+ * key of the outline cache, which may be shared by the faces of a font
+ * collection.
+ *
+ * \return The outline key.
+ */
+outline_cache::key font_impl::get_outline_key() const
+{
+    FT_GlyphSlot const slot(f_face->glyph);
+    FT_Outline const & outline(slot->outline);
+
+    outline_cache::key key;
+    key.f_advance = slot->advance.x;
+    key.f_contours = outline.n_contours;
+    key.f_points = outline.n_points;
+
+    std::string const settings(build_settings_key());
+    outline_cache::hash(key, settings.data(), settings.length());
+    outline_cache::hash(key, &slot->metrics.horiBearingX, sizeof(slot->metrics.horiBearingX));
+    outline_cache::hash(key, &slot->metrics.horiBearingY, sizeof(slot->metrics.horiBearingY));
+    outline_cache::hash(key, &outline.flags, sizeof(outline.flags));
+    outline_cache::hash(key, outline.contours, outline.n_contours * sizeof(*outline.contours));
+    outline_cache::hash(key, outline.points, outline.n_points * sizeof(*outline.points));
+    outline_cache::hash(key, outline.tags, outline.n_points * sizeof(*outline.tags));
+
+    return key;
+}
+
+
+/** \brief Load a composite glyph as a set of components.
+ *
+ * This function loads the glyph with FT_LOAD_NO_RECURSE. If the glyph
+ * is a composite, the function creates a mesh which references the
+ * mesh of each one of its components with their transformation instead
+ * of tessellating the whole flattened outline.
+ *
+ * If the glyph is not a composite or uses a feature we do not support
+ * (i.e. components positioned by matching points), the function returns
+ * nullptr and the caller is expected to load the glyph normally.
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The composite mesh or nullptr.
+ */
+mesh::pointer_t font_impl::load_composite(FT_UInt index)
+{
+    int e(FT_Load_Glyph(f_face, index, FT_LOAD_NO_RECURSE));
+    if(e != FT_Err_Ok
+    || f_face->glyph == nullptr
+    || f_face->glyph->format != FT_GLYPH_FORMAT_COMPOSITE)
+    {
+        return mesh::pointer_t();
+    }
+
+    // copy the info since loading the components reuses the glyph slot
+    //
+    struct subglyph
+    {
+        FT_Int          f_index = 0;
+        FT_UInt         f_flags = 0;
+        FT_Int          f_arg1 = 0;
+        FT_Int          f_arg2 = 0;
+        FT_Matrix       f_transform = FT_Matrix();
+    };
+    std::vector<subglyph> subglyphs(f_face->glyph->num_subglyphs);
+    for(std::size_t i(0); i < subglyphs.size(); ++i)
+    {
+        subglyph & s(subglyphs[i]);
+        e = FT_Get_SubGlyph_Info(
+                  f_face->glyph
+                , i
+                , &s.f_index
+                , &s.f_flags
+                , &s.f_arg1
+                , &s.f_arg2
+                , &s.f_transform);
+        if(e != FT_Err_Ok
+        || (s.f_flags & FT_SUBGLYPH_FLAG_ARGS_ARE_XY_VALUES) == 0)
+        {
+            return mesh::pointer_t();
+        }
+    }
+
+    // the FT_LOAD_NO_RECURSE implies FT_LOAD_NO_SCALE so reload the glyph
+    // to get the scaled metrics (this does not tessellate anything)
+    //
+    e = FT_Load_Glyph(f_face, index, get_freetype_load_flags());
+    if(e != FT_Err_Ok
+    || f_face->glyph == nullptr)
+    {
+        return mesh::pointer_t();
+    }
+
+    mesh::pointer_t result(std::make_shared<mesh>(static_cast<float>(f_face->glyph->advance.x) / static_cast<float>(f_precision)));
+    result->set_bearing(
+              static_cast<float>(f_face->glyph->metrics.horiBearingX) / static_cast<float>(f_precision)
+            , static_cast<float>(f_face->glyph->metrics.horiBearingY) / static_cast<float>(f_precision));
+
+    FT_Fixed const x_scale(f_size->metrics.x_scale);
+    FT_Fixed const y_scale(f_size->metrics.y_scale);
+    for(auto const & s : subglyphs)
+    {
+        mesh::component c;
+        c.f_mesh = get_mesh_by_index(s.f_index);
+        if(c.f_mesh == nullptr)
+        {
+            continue;
+        }
+
+        c.f_matrix[0] = static_cast<double>(s.f_transform.xx) / 65536.0;
+        c.f_matrix[1] = static_cast<double>(s.f_transform.xy) / 65536.0;
+        c.f_matrix[2] = static_cast<double>(s.f_transform.yx) / 65536.0;
+        c.f_matrix[3] = static_cast<double>(s.f_transform.yy) / 65536.0;
+
+        // the offsets are in font units and, like FreeType by default,
+        // we do not apply the component transformation to them
+        //
+        c.f_matrix[4] = static_cast<double>(FT_MulFix(s.f_arg1, x_scale)) / f_precision;
+        c.f_matrix[5] = static_cast<double>(FT_MulFix(s.f_arg2, y_scale)) / f_precision;
+
+        result->add_component(c);
+    }
+
+    return result;
+}
+
+
+mesh::pointer_t font_impl::load_mesh(FT_UInt index)
+{
+    int const e(FT_Load_Glyph(f_face, index, get_freetype_load_flags()));
+    if(e != FT_Err_Ok
+    || f_face->glyph == nullptr)     // the load failed
+    {
+        return mesh::pointer_t();
+    }
+
+    if(f_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+    {
+        // valid load, not a valid format, we expected vertices (an outline)
+        //
+        return mesh::pointer_t();
+    }
+
+    apply_synthetic_style();
+
+    // another glyph with the exact same outline was already tessellated?
+    //
+    outline_cache::key const outline_key(get_outline_key());
+    mesh::pointer_t const existing(f_outline_cache->find(outline_key));
+    if(existing != nullptr)
+    {
+        return existing;
+    }
+
+    int start_index(0);
+    int end_index(0);
+
+    polygon::vector_t polygons;
+    polygons.reserve(f_face->glyph->outline.n_contours);
+
+    for(int i(0); i < f_face->glyph->outline.n_contours; ++i)
+    {
+        end_index = f_face->glyph->outline.contours[i] + 1;
+
+        // contours of less than 3 points have no area, ignore them
+        //
+        if(end_index - start_index >= 3)
+        {
+            polygon::pointer_t p(std::make_shared<polygon>(
+                                  f_face->glyph->outline.points + start_index
+                                , reinterpret_cast<char *>(f_face->glyph->outline.tags) + start_index
+                                , end_index - start_index));
+
+            // the simplification may leave us with a degenerate contour
+            //
+            p->simplify(f_simplify_tolerance * f_precision);
+            if(p->size() >= 3)
+            {
+                polygons.push_back(p);
+            }
+        }
+
+        start_index = end_index;
+    }
+
+    // compute the parity of each polygon
+    //
+    // FIXME: see whether FT_Outline_Get_Orientation can do it for us.
+    //
+    for(std::size_t i(0); i < polygons.size(); ++i)
+    {
+        polygon::pointer_t c1(polygons[i]);
+        point const leftmost(c1->leftmost());
+        int parity(0);
+        for(std::size_t j(0); j < polygons.size(); ++j)
+        {
+            if(j == i)
+            {
+                continue;
+            }
+
+            polygon::pointer_t c2(polygons[j]);
+            for(size_t n(0); n < c2->size(); ++n)
+            {
+                point const p1(c2->at(n));
+                point const p2(c2->at(n + 1));
+
+                /* FIXME: combinations of >= > <= and < do not seem stable */
+                if((p1.y() <  leftmost.y() && p2.y() <  leftmost.y())
+                || (p1.y() >= leftmost.y() && p2.y() >= leftmost.y())
+                || (p1.x() >  leftmost.x() && p2.x() >  leftmost.x()))
+                {
+                    ;
+                }
+                else if(p1.x() < leftmost.x()
+                     && p2.x() < leftmost.x())
+                {
+                    parity++;
+                }
+                else
+                {
+                    point const a(p1 - leftmost);
+                    point const b(p2 - leftmost);
+                    if(b.x() * a.y() > b.y() * a.x())
+                    {
+                        parity++;
+                    }
+                }
+            }
+        }
+
+        c1->apply_parity(parity);
+    }
+
+    f_current_mesh = std::make_shared<mesh>(static_cast<float>(f_face->glyph->advance.x) / static_cast<float>(f_precision));
+    f_current_mesh->set_bearing(
+              static_cast<float>(f_face->glyph->metrics.horiBearingX) / static_cast<float>(f_precision)
+            , static_cast<float>(f_face->glyph->metrics.horiBearingY) / static_cast<float>(f_precision));
+    f_temporary_vertex_pos = 0;
+
+    GLUtesselator * tobj(gluNewTess());
+
+    gluTessCallback(tobj, GLU_TESS_EDGE_FLAG_DATA, reinterpret_cast<_GLUfuncptr>(&tess_callback_edge));
+    gluTessCallback(tobj, GLU_TESS_BEGIN_DATA,     reinterpret_cast<_GLUfuncptr>(&tess_callback_begin));
+    gluTessCallback(tobj, GLU_TESS_VERTEX_DATA,    reinterpret_cast<_GLUfuncptr>(&tess_callback_vertex));
+    gluTessCallback(tobj, GLU_TESS_COMBINE_DATA,   reinterpret_cast<_GLUfuncptr>(&tess_callback_combine));
+    gluTessCallback(tobj, GLU_TESS_END_DATA,       reinterpret_cast<_GLUfuncptr>(&tess_callback_end));
+    gluTessCallback(tobj, GLU_TESS_ERROR_DATA,     reinterpret_cast<_GLUfuncptr>(&tess_callback_error));
+
+    if((f_face->glyph->outline.flags & FT_OUTLINE_EVEN_ODD_FILL) != 0) // ft_outline_reverse_fill
+    {
+        gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_ODD);
+    }
+    else
+    {
+        gluTessProperty(tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_NONZERO);
+    }
+
+    gluTessProperty(tobj, GLU_TESS_BOUNDARY_ONLY, GLU_FALSE);
+    gluTessProperty(tobj, GLU_TESS_TOLERANCE, 0.0);
+    gluTessNormal(tobj, 0.0, 0.0, 1.0);
+
+    gluTessBeginPolygon(tobj, this);
+
+        for(std::size_t c(0); c < polygons.size(); ++c)
+        {
+            gluTessBeginContour(tobj);
+
+                polygon::pointer_t polygon(polygons[c]);
+                for(std::size_t p(0); p < polygon->size(); ++p)
+                {
+                    gluTessVertex(
+                          tobj
+                        , const_cast<double *>(polygon->at(p).f_coordinates)
+                        , const_cast<double *>(polygon->at(p).f_coordinates));
+                }
+
+            gluTessEndContour(tobj);
+        }
+
+    gluTessEndPolygon(tobj);
+
+    gluDeleteTess(tobj);
+
+    mesh::pointer_t result;
+    f_current_mesh.swap(result);
+    result->optimize(f_mesh_format);
+    slab::pointer_t const storage(get_slab());
+    if(storage != nullptr)
+    {
+        result = result->copy(storage);
+    }
+    return f_outline_cache->add(outline_key, result);
+}
+
+
+void font_impl::set_precision(int precision)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if(precision <= 0)
+    {
+        throw std::runtime_error("the precision must be positive");
+    }
+
+    f_precision = precision;
+    f_settings_key.clear();
+    for(auto & c : f_variant_caches)
+    {
+        c.second.f_index_kerning_map.clear();
+    }
+
+    // the size is expressed in 26.6 multiplied by the precision
+    //
+    f_size_dirty = true;
+    if(lock.owns_lock())
+    {
+        apply_size();
+    }
+}
+
+
+bool font_impl::has_kerning_table() const
+{
+    return FT_HAS_KERNING(f_face) != 0; 
+}
+
+
+/** \brief Set the size of the font.
+ *
+ * This function sets the size of the font. You must have called the
+ * set_precision() function first if you want your new precision to work.
+ *
+ * The \p point_size is the usual \em point definition. More or less, the
+ * height, knowing that it is not going to match the pixel height.
+ *
+ * \note
+ * The default size is:
+ *
+ * \code
+ *     set_size(DEFAULT_SIZE, DEFAULT_RESOLUTION, DEFAULT_RESOLUTION);
+ * \endcode
+ *
+ * If the face is not open yet (see open_mode_t), the size is applied
+ * once it gets opened.
+ *
+ * \warning
+ * It is important to call this function BEFORE you ever call the get_mesh()
+ * or convert_string(). Also, calling this function AFTER will not work as
+ * expected (i.e. it doesn't dynamically reset all the existing glyph and
+ * restart with the new size). In a future version, we may fix this issue.
+ *
+ * \param[in] point_size  The font height to use.
+ * \param[in] x_resolution  The horizontal resolution, 72 by default.
+ * \param[in] y_resolution  The vertical resolution, 72 by default.
  */
 void font_impl::set_size(int point_size, int x_resolution, int y_resolution)
 {
-    int const e(FT_Set_Char_Size(
-              f_face
-            , 0L
-            , point_size * f_precision
-            , x_resolution
-            , y_resolution));
-    if(e != FT_Err_Ok)
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    f_point_size = point_size;
+    f_x_resolution = x_resolution;
+    f_y_resolution = y_resolution;
+    f_settings_key.clear();
+    for(auto & c : f_variant_caches)
+    {
+        c.second.f_index_kerning_map.clear();
+    }
+
+    f_size_dirty = true;
+    if(lock.owns_lock())
+    {
+        apply_size();
+    }
+}
+
+
+/** \brief Apply the size settings to our FT_Size.
+ *
+ * The caller must hold f_mutex and have activated f_size.
+ */
+void font_impl::apply_size()
+{
+    f_size_dirty = false;
+
+    int const e(FT_Set_Char_Size(
+              f_face
+            , 0L
+            , f_point_size * f_precision
+            , f_x_resolution
+            , f_y_resolution));
+    if(e != FT_Err_Ok)
+    {
+        SNAP_LOG_ERROR
+            << "FT_Set_Char_Size() failed with error #"
+            << e
+            << " for point: "
+            << f_point_size * f_precision
+            << " (including the upscaling), horizontal resolution: "
+            << f_x_resolution
+            << ", vertical resolution: "
+            << f_y_resolution
+            << SNAP_LOG_SEND;
+    }
+}
+
+
+/** \brief Set the tolerance used to simplify the glyph contours.
+ *
+ * Before tessellating a glyph, its contours get cleaned up: points which
+ * are within \p tolerance of the simplified contour (near duplicates,
+ * collinear runs, flat sections of curves) are removed. This reduces
+ * the number of triangles generated while keeping every original point
+ * within \p tolerance of the final shape.
+ *
+ * The \p tolerance is expressed in the same units as the output mesh
+ * (i.e. after the precision was removed). Use 0.0 to turn off the
+ * simplification.
+ *
+ * \param[in] tolerance  The maximum distance between a removed point
+ * and the simplified contour.
+ */
+void font_impl::set_simplify_tolerance(double tolerance)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if(tolerance < 0.0)
+    {
+        throw std::runtime_error("the simplify tolerance cannot be negative");
+    }
+
+    f_simplify_tolerance = tolerance;
+    f_settings_key.clear();
+}
+
+
+/** \brief Select the format of the meshes.
+ *
+ * By default, the meshes are plain lists of triangles (GL_TRIANGLES)
+ * as generated by the GLU tessellator. This function lets you request
+ * indexed triangles or triangle strips instead. In both cases the
+ * triangles get reordered to make better use of the GPU vertex cache.
+ *
+ * See mesh::optimize() for details.
+ *
+ * \param[in] format  The format of the meshes generated from now on.
+ */
+void font_impl::set_mesh_format(mesh_format_t format)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    f_mesh_format = format;
+    f_settings_key.clear();
+}
+
+
+/** \brief Reuse the components of composite glyphs.
+ *
+ * Accented letters are often defined as a composite of other glyphs.
+ * By default, the whole composite gets flattened by FreeType and
+ * tessellated for each character.
+ *
+ * When this flag is set, composites are instead loaded as a list of
+ * components and each component is tessellated once and shared. The
+ * composite meshes then have no points of their own; see
+ * mesh::get_components() and mesh::flatten().
+ *
+ * This only works with TrueType fonts. Other fonts are not affected.
+ *
+ * \param[in] reuse  Whether to reuse the components of composites.
+ */
+void font_impl::set_reuse_composites(bool reuse)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    f_reuse_composites = reuse;
+    f_settings_key.clear();
+}
+
+
+/** \brief Save the meshes in a slab.
+ *
+ * By default, each mesh allocates its points and indexes on the heap.
+ * With a slab, the data of all the meshes built from now on is
+ * allocated back to back in a few large blocks (kept alive by the
+ * meshes). This improves locality when walking the glyphs of a string
+ * and avoids fragmenting the heap in long running processes.
+ *
+ * A slab never gives memory back on its own so each variant (see
+ * select_variant()) gets its own slab. When a variant gets evicted,
+ * its slab is released along its meshes, once the caller does not
+ * hold any of them anymore. A mesh found in the outline cache by
+ * another variant keeps the slab of the variant which created it.
+ *
+ * Turning the slab off does not affect the meshes already created.
+ *
+ * \param[in] use_slab  Whether to allocate new meshes in a slab.
+ */
+void font_impl::set_slab_storage(bool use_slab)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    f_use_slab = use_slab;
+    if(!use_slab)
+    {
+        for(auto & c : f_variant_caches)
+        {
+            c.second.f_slab.reset();
+        }
+    }
+}
+
+
+/** \brief Get the slab of the current variant.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \return The slab where new meshes get allocated or nullptr when the
+ * slab storage is turned off.
+ */
+slab::pointer_t font_impl::get_slab()
+{
+    if(!f_use_slab)
+    {
+        return slab::pointer_t();
+    }
+    if(f_cache->f_slab == nullptr)
+    {
+        f_cache->f_slab = std::make_shared<slab>();
+    }
+    return f_cache->f_slab;
+}
+
+
+/** \brief Get a key representing the settings used to build meshes.
+ *
+ * Two strings converted with different settings (size, precision,
+ * mesh format...) give different results. This key is used along the
+ * text of a string to search the string cache. It is rebuilt only after
+ * a setting changed.
+ *
+ * \return A string representing the current settings.
+ */
+std::string const & font_impl::get_settings_key()
+{
+    if(f_settings_key.empty())
+    {
+        f_settings_key = build_settings_key();
+    }
+    return f_settings_key;
+}
+
+
+std::string font_impl::build_settings_key() const
+{
+    return std::to_string(f_precision)
+         + ':' + std::to_string(f_point_size)
+         + ':' + std::to_string(f_x_resolution)
+         + ':' + std::to_string(f_y_resolution)
+         + ':' + std::to_string(f_simplify_tolerance)
+         + ':' + std::to_string(static_cast<int>(f_mesh_format))
+         + ':' + (f_reuse_composites ? '1' : '0')
+         + ':' + get_variant_key()
+         + '|';
+}
+
+
+/** \brief Get a key representing the variant of the glyphs.
+ *
+ * The variant is defined by the load flags, the synthetic styles and
+ * the variation coordinates. Each variant has its own maps of meshes.
+ *
+ * \return The variant key.
+ */
+std::string font_impl::get_variant_key() const
+{
+    std::string key(std::to_string(f_load_flags)
+                  + ':' + std::to_string(f_synthetic_bold)
+                  + ':' + std::to_string(f_synthetic_oblique));
+    for(FT_Fixed const c : f_coordinates)
+    {
+        key += ':';
+        key += std::to_string(c);
+    }
+    return key;
+}
+
+
+/** \brief Convert the load flags to FreeType load flags.
+ *
+ * \return The flags to pass to FT_Load_Glyph().
+ */
+FT_Int32 font_impl::get_freetype_load_flags() const
+{
+    FT_Int32 flags(FT_LOAD_DEFAULT);
+    if((f_load_flags & LOAD_FLAG_NO_HINTING) != 0)
+    {
+        flags |= FT_LOAD_NO_HINTING;
+    }
+    else if((f_load_flags & LOAD_FLAG_TARGET_LIGHT) != 0)
+    {
+        flags |= FT_LOAD_TARGET_LIGHT;
+    }
+    if((f_load_flags & LOAD_FLAG_NO_BITMAP) != 0)
+    {
+        flags |= FT_LOAD_NO_BITMAP;
+    }
+    return flags;
+}
+
+
+/** \brief Switch to the maps of the current variant.
+ *
+ * At most MAX_VARIANT_CACHES variants are kept. When a new variant is
+ * needed and that many exist, the least recently selected one gets
+ * dropped. The current variant is the most recently selected so it
+ * never gets dropped.
+ *
+ * The caller must hold the settings lock.
+ */
+void font_impl::select_variant()
+{
+    std::string const key(get_variant_key());
+    auto it(f_variant_caches.find(key));
+    if(it == f_variant_caches.end())
+    {
+        if(f_variant_caches.size() >= MAX_VARIANT_CACHES)
+        {
+            auto const oldest(std::min_element(
+                      f_variant_caches.begin()
+                    , f_variant_caches.end()
+                    , [](auto const & a, auto const & b)
+                      {
+                          return a.second.f_last_used < b.second.f_last_used;
+                      }));
+#ifdef FTMESH_HARFBUZZ
+            destroy_shape_plans(oldest->second);
+#endif
+            f_variant_caches.erase(oldest);
+        }
+        it = f_variant_caches.emplace(key, variant_cache()).first;
+    }
+    ++f_variant_clock;
+    it->second.f_last_used = f_variant_clock;
+
+    f_cache = &it->second;
+    f_settings_key.clear();
+}
+
+
+/** \brief Build the string cache key of \p message.
+ *
+ * The key is the settings key followed by the UTF-8 bytes of the
+ * message. It is built in a buffer reused by each call so the lookup
+ * does not allocate memory once the buffer is large enough. The
+ * returned view is only valid until the next call.
+ *
+ * \param[in] message  The UTF-8 string to convert.
+ *
+ * \return A view on the key.
+ */
+std::string_view font_impl::get_string_key(std::string_view message)
+{
+    f_string_key = get_settings_key();
+    f_string_key += message;
+    return f_string_key;
+}
+
+
+/** \brief Build the string cache key of a UTF-32 \p message.
+ *
+ * The message gets encoded to UTF-8 directly in the key buffer so a
+ * UTF-32 string finds the entries of the same UTF-8 string without
+ * allocating temporary strings. The UTF-8 message starts right after
+ * the settings key (see get_settings_key()).
+ *
+ * \param[in] message  The UTF-32 string to convert.
+ *
+ * \return A view on the key.
+ */
+std::string_view font_impl::get_string_key(std::u32string_view message)
+{
+    f_string_key = get_settings_key();
+    for(char32_t const c : message)
+    {
+        char buf[libutf8::MBS_MIN_BUFFER_LENGTH];
+        int const length(libutf8::wctombs(buf, c, sizeof(buf)));
+        if(length > 0)
+        {
+            f_string_key.append(buf, static_cast<std::size_t>(length));
+        }
+    }
+    return f_string_key;
+}
+
+
+/** \brief Share the meshes with other processes.
+ *
+ * See font::set_shared_cache() for details.
+ *
+ * \param[in] name  The name of the shared memory segment or an empty
+ * string to stop using a shared cache.
+ * \param[in] size  The size of the segment.
+ */
+void font_impl::set_shared_cache(std::string const & name, std::size_t size)
+{
+    shared_cache::pointer_t cache;
+    if(!name.empty())
+    {
+        cache = std::make_shared<shared_cache>(name, size);
+    }
+
+    std::unique_lock<std::mutex> lock(lock_settings());
+    f_shared_cache = cache;
+}
+
+
+/** \brief Share the outline cache with other fonts.
+ *
+ * This is used by font_collection so identical outlines found in
+ * several faces of the collection get tessellated only once.
+ *
+ * \param[in] cache  The cache to use from now on.
+ */
+void font_impl::set_outline_cache(outline_cache::pointer_t cache)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+    f_outline_cache = cache;
+}
+
+
+string_cache & font_impl::get_string_cache()
+{
+    return f_string_cache;
+}
+
+
+/** \brief Get the glyph pool matching the current settings.
+ *
+ * The pool is created on the first call and replaced by a new one each
+ * time the settings used to build the meshes change (format, size,
+ * variant...). This way the pool never mixes incompatible meshes and
+ * the old geometry gets released along the old pool.
+ *
+ * \return The glyph pool to use with the current settings.
+ */
+glyph_pool::pointer_t font_impl::get_glyph_pool()
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    std::string const & key(get_settings_key());
+    if(f_glyph_pool == nullptr
+    || f_glyph_pool_key != key)
+    {
+        f_glyph_pool = std::make_shared<glyph_pool>(f_mesh_format);
+        f_glyph_pool_key = key;
+    }
+    return f_glyph_pool;
+}
+
+
+float font_impl::get_kerning(char32_t current_char, char32_t next_char)
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    return get_cached_kerning(
+              FT_Get_Char_Index(f_face, current_char)
+            , FT_Get_Char_Index(f_face, next_char));
+}
+
+
+/** \brief Get the kerning between two glyphs from their index.
+ *
+ * This is the same as get_kerning() for callers which already know the
+ * glyph indexes.
+ *
+ * \param[in] current_index  The index of the glyph on the left.
+ * \param[in] next_index  The index of the glyph on the right.
+ *
+ * \return The kerning adjustment.
+ */
+float font_impl::get_kerning_by_index(FT_UInt current_index, FT_UInt next_index)
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    return get_cached_kerning(current_index, next_index);
+}
+
+
+/** \brief Get the kerning between two glyphs from the cache.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] current_index  The index of the glyph on the left.
+ * \param[in] next_index  The index of the glyph on the right.
+ *
+ * \return The kerning adjustment.
+ */
+float font_impl::get_cached_kerning(FT_UInt current_index, FT_UInt next_index)
+{
+    std::uint64_t const key((static_cast<std::uint64_t>(current_index) << 32) | next_index);
+    auto it(f_cache->f_index_kerning_map.find(key));
+    if(it != f_cache->f_index_kerning_map.end())
+    {
+        return it->second;
+    }
+
+    float const result(load_kerning(current_index, next_index));
+    if(f_cache->f_index_kerning_map.size() >= MAX_KERNING_PAIRS)
+    {
+        f_cache->f_index_kerning_map.clear();
+    }
+    f_cache->f_index_kerning_map[key] = result;
+    return result;
+}
+
+
+/** \brief Read the kerning of a pair of glyphs from the face.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] current_index  The index of the glyph on the left.
+ * \param[in] next_index  The index of the glyph on the right.
+ *
+ * \return The kerning adjustment.
+ */
+float font_impl::load_kerning(FT_UInt current_index, FT_UInt next_index)
+{
+    FT_Vector kern_advance = FT_Vector();
+
+    //if(has_kerning_table()) -- TBD
+    {
+        int const e(FT_Get_Kerning(
+                  f_face
+                , current_index
+                , next_index
+                , FT_KERNING_UNFITTED
+                , &kern_advance));
+        if(e != FT_Err_Ok)
+        {
+            // this is probably common?
+        }
+    }
+
+    return static_cast<float>(kern_advance.x) / static_cast<float>(f_precision);
+}
+
+
+/** \brief Get the distance between two baselines.
+ *
+ * This is the height defined in the font face scaled to the current
+ * size, in the same units as the meshes.
+ *
+ * \return The line height.
+ */
+float font_impl::get_line_height()
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+    return static_cast<float>(f_size->metrics.height) / static_cast<float>(f_precision);
+}
+
+
+/** \brief Get the list of characters defined in the face.
+ *
+ * The list is read from the Unicode charmap so no glyph gets loaded.
+ *
+ * \return The characters in increasing order.
+ */
+std::u32string font_impl::get_characters()
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    std::u32string result;
+    result.reserve(f_face->num_glyphs);
+    FT_UInt index(0);
+    FT_ULong c(FT_Get_First_Char(f_face, &index));
+    while(index != 0)
+    {
+        result += static_cast<char32_t>(c);
+        c = FT_Get_Next_Char(f_face, c, &index);
+    }
+    return result;
+}
+
+
+/** \brief Get the variation axes of a variable font.
+ *
+ * \return The axes, an empty vector if this is not a variable font.
+ */
+variation_axis::vector_t font_impl::get_variation_axes()
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    variation_axis::vector_t result;
+    FT_MM_Var const * variations(f_shared_face->get_variations());
+    if(variations != nullptr)
+    {
+        result.reserve(variations->num_axis);
+        for(FT_UInt i(0); i < variations->num_axis; ++i)
+        {
+            FT_Var_Axis const & a(variations->axis[i]);
+            variation_axis axis;
+            axis.f_name = a.name == nullptr ? std::string() : a.name;
+            axis.f_tag = static_cast<std::uint32_t>(a.tag);
+            axis.f_minimum = static_cast<double>(a.minimum) / 65536.0;
+            axis.f_default = static_cast<double>(a.def) / 65536.0;
+            axis.f_maximum = static_cast<double>(a.maximum) / 65536.0;
+            result.push_back(axis);
+        }
+    }
+    return result;
+}
+
+
+/** \brief Get the named instances of a variable font.
+ *
+ * \return The named instances, an empty vector if this is not a variable
+ * font.
+ */
+named_instance::vector_t font_impl::get_named_instances()
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    named_instance::vector_t result;
+    FT_MM_Var const * variations(f_shared_face->get_variations());
+    if(variations != nullptr)
+    {
+        result.reserve(variations->num_namedstyles);
+        for(FT_UInt i(0); i < variations->num_namedstyles; ++i)
+        {
+            FT_Var_Named_Style const & style(variations->namedstyle[i]);
+            named_instance instance;
+            instance.f_name = get_name(style.strid);
+            instance.f_coordinates.reserve(variations->num_axis);
+            for(FT_UInt j(0); j < variations->num_axis; ++j)
+            {
+                instance.f_coordinates.push_back(static_cast<double>(style.coords[j]) / 65536.0);
+            }
+            result.push_back(instance);
+        }
+    }
+    return result;
+}
+
+
+/** \brief Get a string from the name table of the face.
+ *
+ * The English Unicode name is preferred. Names using other encodings
+ * are only used if no Unicode name exists and only their ASCII
+ * characters are kept.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] name_id  The identifier of the name.
+ *
+ * \return The name or an empty string if not found.
+ */
+std::string font_impl::get_name(FT_UInt name_id) const
+{
+    std::string result;
+    int best(0);
+    FT_UInt const count(FT_Get_Sfnt_Name_Count(f_face));
+    for(FT_UInt i(0); i < count; ++i)
+    {
+        FT_SfntName name;
+        if(FT_Get_Sfnt_Name(f_face, i, &name) != FT_Err_Ok
+        || name.name_id != name_id)
+        {
+            continue;
+        }
+
+        bool const unicode(name.platform_id == TT_PLATFORM_MICROSOFT
+                        || name.platform_id == TT_PLATFORM_APPLE_UNICODE);
+        int const score(unicode
+                            ? (name.language_id == TT_MS_LANGID_ENGLISH_UNITED_STATES ? 3 : 2)
+                            : 1);
+        if(score <= best)
+        {
+            continue;
+        }
+        best = score;
+
+        result.clear();
+        if(unicode)
+        {
+            // UTF-16BE
+            //
+            std::u32string utf32;
+            for(FT_UInt j(0); j + 1 < name.string_len; j += 2)
+            {
+                char32_t c((name.string[j] << 8) | name.string[j + 1]);
+                if(c >= 0xD800 && c <= 0xDBFF && j + 3 < name.string_len)
+                {
+                    char32_t const low((name.string[j + 2] << 8) | name.string[j + 3]);
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    j += 2;
+                }
+                utf32 += c;
+            }
+            result = libutf8::to_u8string(utf32);
+        }
+        else
+        {
+            for(FT_UInt j(0); j < name.string_len; ++j)
+            {
+                if(name.string[j] < 0x80)
+                {
+                    result += static_cast<char>(name.string[j]);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+
+/** \brief Change the variation coordinates.
+ *
+ * See font::set_variation() for details.
+ *
+ * \exception std::logic_error
+ * Coordinates were specified for a font which is not a variable font.
+ * \exception std::out_of_range
+ * More coordinates than axes were specified.
+ *
+ * \param[in] coordinates  The design coordinates, one per axis.
+ *
+ * \return true if the coordinates changed.
+ */
+bool font_impl::set_variation(std::vector<double> const & coordinates)
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    FT_MM_Var const * variations(f_shared_face->get_variations());
+    if(variations == nullptr)
+    {
+        if(coordinates.empty())
+        {
+            return false;
+        }
+        throw std::logic_error("\"" + f_filename + "\" is not a variable font.");
+    }
+    if(coordinates.size() > variations->num_axis)
+    {
+        throw std::out_of_range(
+                  "too many variation coordinates ("
+                + std::to_string(coordinates.size())
+                + ") for \""
+                + f_filename
+                + "\" which has "
+                + std::to_string(variations->num_axis)
+                + " axes.");
+    }
+
+    std::vector<FT_Fixed> fixed(variations->num_axis);
+    for(FT_UInt i(0); i < variations->num_axis; ++i)
+    {
+        FT_Var_Axis const & a(variations->axis[i]);
+        double const minimum(static_cast<double>(a.minimum) / 65536.0);
+        double const maximum(static_cast<double>(a.maximum) / 65536.0);
+        double value(i < coordinates.size()
+                        ? coordinates[i]
+                        : static_cast<double>(a.def) / 65536.0);
+        value = std::clamp(value, minimum, maximum);
+        if(f_variation_step > 0.0)
+        {
+            value = std::clamp(std::round(value / f_variation_step) * f_variation_step, minimum, maximum);
+        }
+        fixed[i] = static_cast<FT_Fixed>(std::lround(value * 65536.0));
+    }
+
+    if(f_snap_to_named_instances
+    && variations->num_namedstyles > 0)
+    {
+        // the distance uses coordinates normalized to [0, 1] so all the
+        // axes have the same weight
+        //
+        double best_distance(0.0);
+        FT_UInt best(0);
+        for(FT_UInt i(0); i < variations->num_namedstyles; ++i)
+        {
+            double distance(0.0);
+            for(FT_UInt j(0); j < variations->num_axis; ++j)
+            {
+                FT_Var_Axis const & a(variations->axis[j]);
+                if(a.maximum > a.minimum)
+                {
+                    double const d(static_cast<double>(variations->namedstyle[i].coords[j] - fixed[j])
+                                 / static_cast<double>(a.maximum - a.minimum));
+                    distance += d * d;
+                }
+            }
+            if(i == 0
+            || distance < best_distance)
+            {
+                best_distance = distance;
+                best = i;
+            }
+        }
+        fixed.assign(
+                  variations->namedstyle[best].coords
+                , variations->namedstyle[best].coords + variations->num_axis);
+    }
+
+    // use an empty vector for the defaults so they always have the same key
+    //
+    bool defaults(true);
+    for(FT_UInt i(0); i < variations->num_axis; ++i)
+    {
+        if(fixed[i] != variations->axis[i].def)
+        {
+            defaults = false;
+            break;
+        }
+    }
+    if(defaults)
+    {
+        fixed.clear();
+    }
+
+    if(fixed == f_coordinates)
+    {
+        return false;
+    }
+
+    f_coordinates = fixed;
+    select_variant();
+    apply_coordinates();
+    if(f_size_dirty)
+    {
+        apply_size();
+    }
+
+    return true;
+}
+
+
+/** \brief Get the variation coordinates in use.
+ *
+ * \return The design coordinates of each axis, after quantization and
+ * snapping, or an empty vector if this is not a variable font.
+ */
+std::vector<double> font_impl::get_variation()
+{
+    std::unique_lock<std::mutex> lock(lock_face());
+
+    std::vector<double> result;
+    FT_MM_Var const * variations(f_shared_face->get_variations());
+    if(variations != nullptr)
+    {
+        result.reserve(variations->num_axis);
+        for(FT_UInt i(0); i < variations->num_axis; ++i)
+        {
+            FT_Fixed const c(f_coordinates.empty()
+                                ? variations->axis[i].def
+                                : f_coordinates[i]);
+            result.push_back(static_cast<double>(c) / 65536.0);
+        }
+    }
+    return result;
+}
+
+
+void font_impl::set_variation_step(double step)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if(step < 0.0)
+    {
+        throw std::runtime_error("the variation step cannot be negative");
+    }
+
+    f_variation_step = step;
+}
+
+
+void font_impl::set_snap_to_named_instances(bool snap)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    f_snap_to_named_instances = snap;
+}
+
+
+/** \brief Make the glyph bolder.
+ *
+ * See font::set_synthetic_bold() for details.
+ *
+ * \exception std::runtime_error
+ * The \p strength is negative.
+ *
+ * \param[in] strength  The strength as a fraction of the em size, 0.0
+ * to turn synthetic bold off.
+ *
+ * \return true if the strength changed.
+ */
+bool font_impl::set_synthetic_bold(double strength)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if(strength < 0.0)
+    {
+        throw std::runtime_error("the synthetic bold strength cannot be negative");
+    }
+    if(strength == f_synthetic_bold)
+    {
+        return false;
+    }
+
+    f_synthetic_bold = strength;
+    select_variant();
+    return true;
+}
+
+
+/** \brief Slant the glyphs.
+ *
+ * See font::set_synthetic_oblique() for details.
+ *
+ * \param[in] slant  The horizontal shift per unit of height, 0.0 to turn
+ * synthetic oblique off.
+ *
+ * \return true if the slant changed.
+ */
+bool font_impl::set_synthetic_oblique(double slant)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if(slant == f_synthetic_oblique)
+    {
+        return false;
+    }
+
+    f_synthetic_oblique = slant;
+    select_variant();
+    return true;
+}
+
+
+/** \brief Change the flags used to load the glyphs.
+ *
+ * See font::set_load_flags() for details.
+ *
+ * \exception std::runtime_error
+ * The \p flags include unknown bits.
+ *
+ * \param[in] flags  The new load flags.
+ *
+ * \return true if the flags changed.
+ */
+bool font_impl::set_load_flags(load_flags_t flags)
+{
+    std::unique_lock<std::mutex> lock(lock_settings());
+
+    if((flags & ~LOAD_FLAG_ALL) != 0)
+    {
+        throw std::runtime_error(
+                  "unknown load flags ("
+                + std::to_string(flags & ~LOAD_FLAG_ALL)
+                + ").");
+    }
+    if(flags == f_load_flags)
+    {
+        return false;
+    }
+
+    f_load_flags = flags;
+    select_variant();
+    return true;
+}
+
+
+load_flags_t font_impl::get_load_flags() const
+{
+    return f_load_flags;
+}
+
+
+/** \brief Apply the synthetic styles to the outline in the glyph slot.
+ *
+ * The outline gets emboldened and sheared before it is flattened and
+ * tessellated. The metrics are adjusted the same way as
+ * FT_GlyphSlot_Embolden() does so the advance includes the extra width.
+ *
+ * The caller must hold f_mutex and have loaded a glyph.
+ */
+void font_impl::apply_synthetic_style()
+{
+    FT_GlyphSlot const slot(f_face->glyph);
+    if(slot->format != FT_GLYPH_FORMAT_OUTLINE)
+    {
+        return;
+    }
+
+    if(f_synthetic_bold > 0.0)
+    {
+        FT_Pos const strength(get_synthetic_bold_strength());
+        if(strength > 0
+        && FT_Outline_Embolden(&slot->outline, strength) == FT_Err_Ok)
+        {
+            slot->metrics.width += strength;
+            slot->metrics.height += strength;
+            slot->metrics.horiBearingY += strength;
+            slot->metrics.horiAdvance += strength;
+            if(slot->advance.x != 0)
+            {
+                slot->advance.x += strength;
+            }
+        }
+    }
+
+    if(f_synthetic_oblique != 0.0)
+    {
+        FT_Matrix shear;
+        shear.xx = 0x10000;
+        shear.xy = static_cast<FT_Fixed>(std::lround(f_synthetic_oblique * 65536.0));
+        shear.yx = 0;
+        shear.yy = 0x10000;
+        FT_Outline_Transform(&slot->outline, &shear);
+    }
+}
+
+
+/** \brief Get the number of units by which the glyphs get emboldened.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \return The synthetic bold strength in 26.6 units of the current size.
+ */
+FT_Pos font_impl::get_synthetic_bold_strength() const
+{
+    FT_Pos const em(FT_MulFix(f_face->units_per_EM, f_size->metrics.y_scale));
+    return static_cast<FT_Pos>(std::lround(static_cast<double>(em) * f_synthetic_bold));
+}
+
+
+/** \brief Shape a string.
+ *
+ * See font::shape() for details.
+ *
+ * \param[in] text  The string to shape.
+ *
+ * \return The shaped glyphs.
+ */
+shaped_glyph::vector_t font_impl::shape(std::u32string_view text)
+{
+    if(text.empty())
+    {
+        return shaped_glyph::vector_t();
+    }
+
+    std::unique_lock<std::mutex> lock(lock_face());
+
+#ifdef FTMESH_HARFBUZZ
+    if(f_hb_font == nullptr)
+    {
+        f_hb_font = hb_ft_font_create_referenced(f_face);
+    }
+
+    // our size and coordinates were just applied to the face, which
+    // may be shared with other fonts, so always resynchronize
+    //
+    hb_ft_font_set_load_flags(f_hb_font, get_freetype_load_flags());
+    hb_ft_font_changed(f_hb_font);
+
+    hb_buffer_t * buffer(g_hb_buffer.get());
+    hb_buffer_add_utf32(
+              buffer
+            , reinterpret_cast<std::uint32_t const *>(text.data())
+            , static_cast<int>(text.length())
+            , 0
+            , static_cast<int>(text.length()));
+    hb_buffer_guess_segment_properties(buffer);
+
+    hb_segment_properties_t properties;
+    hb_buffer_get_segment_properties(buffer, &properties);
+    if(hb_shape_plan_execute(get_shape_plan(properties), f_hb_font, buffer, nullptr, 0))
+    {
+        unsigned int count(0);
+        hb_glyph_info_t const * info(hb_buffer_get_glyph_infos(buffer, &count));
+        hb_glyph_position_t const * position(hb_buffer_get_glyph_positions(buffer, &count));
+
+        // HarfBuzz does not know about our synthetic bold
+        //
+        FT_Pos const strength(f_synthetic_bold > 0.0 ? get_synthetic_bold_strength() : 0);
+
+        float const precision(static_cast<float>(f_precision));
+        shaped_glyph::vector_t result(count);
+        for(unsigned int i(0); i < count; ++i)
+        {
+            shaped_glyph & g(result[i]);
+            g.f_index = info[i].codepoint;
+            g.f_code_point = text[info[i].cluster];
+            hb_position_t x_advance(position[i].x_advance);
+            if(x_advance != 0)
+            {
+                x_advance += strength;
+            }
+            g.f_x_advance = static_cast<float>(x_advance) / precision;
+            g.f_y_advance = static_cast<float>(position[i].y_advance) / precision;
+            g.f_x_offset = static_cast<float>(position[i].x_offset) / precision;
+            g.f_y_offset = static_cast<float>(position[i].y_offset) / precision;
+        }
+        return result;
+    }
+
+    SNAP_LOG_ERROR
+        << "hb_shape_plan_execute() failed for \""
+        << f_filename
+        << "\", using the kerning table instead."
+        << SNAP_LOG_SEND;
+#endif
+
+    return shape_with_kerning(text);
+}
+
+
+/** \brief Shape a string using the legacy kerning table.
+ *
+ * This is used when the library was compiled without HarfBuzz. Each
+ * character becomes one glyph and its advance is the advance of its
+ * mesh plus the kerning with the following character.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] text  The string to shape.
+ *
+ * \return The shaped glyphs.
+ */
+shaped_glyph::vector_t font_impl::shape_with_kerning(std::u32string_view text)
+{
+    shaped_glyph::vector_t result(text.length());
+    for(std::size_t i(0); i < text.length(); ++i)
+    {
+        shaped_glyph & g(result[i]);
+        g.f_index = FT_Get_Char_Index(f_face, text[i]);
+        g.f_code_point = text[i];
+    }
+    for(std::size_t i(0); i < result.size(); ++i)
+    {
+        shaped_glyph & g(result[i]);
+        mesh::pointer_t m(get_shared_mesh(g.f_index));
+        if(m != nullptr)
+        {
+            g.f_x_advance = m->get_advance();
+            if(i + 1 < result.size())
+            {
+                g.f_x_advance += get_cached_kerning(g.f_index, result[i + 1].f_index);
+            }
+        }
+    }
+    return result;
+}
+
+
+#ifdef FTMESH_HARFBUZZ
+/** \brief Get the shape plan for a segment.
+ *
+ * Creating a shape plan means compiling the OpenType lookups of the
+ * script and language. The plans are kept with the meshes of the
+ * variant so this is done once per script, language and direction of
+ * each set of variation coordinates.
+ *
+ * The caller must hold f_mutex.
+ *
+ * \param[in] properties  The properties of the segment to shape.
+ *
+ * \return The shape plan.
+ */
+hb_shape_plan_t * font_impl::get_shape_plan(hb_segment_properties_t const & properties)
+{
+    char const * language(hb_language_to_string(properties.language));
+    std::string const key(
+              std::to_string(static_cast<int>(properties.direction))
+            + ':' + std::to_string(static_cast<std::uint32_t>(properties.script))
+            + ':' + (language == nullptr ? "" : language));
+    auto it(f_cache->f_shape_plans.find(key));
+    if(it != f_cache->f_shape_plans.end())
+    {
+        return it->second;
+    }
+
+    unsigned int coordinate_count(0);
+    int const * coordinates(hb_font_get_var_coords_normalized(f_hb_font, &coordinate_count));
+    hb_shape_plan_t * plan(hb_shape_plan_create_cached2(
+              hb_font_get_face(f_hb_font)
+            , &properties
+            , nullptr
+            , 0
+            , coordinates
+            , coordinate_count
+            , nullptr));
+    f_cache->f_shape_plans[key] = plan;
+    return plan;
+}
+
+
+/** \brief Release the shape plans of a variant.
+ *
+ * \param[in] cache  The variant cache being dropped.
+ */
+void font_impl::destroy_shape_plans(variant_cache & cache)
+{
+    for(auto const & p : cache.f_shape_plans)
+    {
+        hb_shape_plan_destroy(p.second);
+    }
+    cache.f_shape_plans.clear();
+}
+#endif
+
+
+/** \brief Apply our variation coordinates to the face.
+ *
+ * The coordinates are saved in the face, which is shared with other
+ * fonts, so they get applied again only if another font changed them.
+ * The metrics of the sizes may change with the coordinates so the size
+ * gets applied again too.
+ *
+ * The caller must hold f_mutex.
+ */
+void font_impl::apply_coordinates()
+{
+    std::vector<FT_Fixed> & current(f_shared_face->get_coordinates());
+    if(current == f_coordinates)
+    {
+        return;
+    }
+
+    FT_Error const e(f_coordinates.empty()
+            ? FT_Set_Var_Design_Coordinates(f_face, 0, nullptr)
+            : FT_Set_Var_Design_Coordinates(
+                      f_face
+                    , static_cast<FT_UInt>(f_coordinates.size())
+                    , f_coordinates.data()));
+    if(e != FT_Err_Ok)
+    {
+        SNAP_LOG_ERROR
+            << "FT_Set_Var_Design_Coordinates() failed with error #"
+            << e
+            << " for \""
+            << f_filename
+            << "\"."
+            << SNAP_LOG_SEND;
+    }
+
+    current = f_coordinates;
+    f_size_dirty = true;
+}
+
+
+void font_impl::tess_callback_edge(GLboolean edge, font_impl * impl)
+{
+    // we have this callback to force the GLU library to only create
+    // triangles (GL_TRIANGLES); that way we avoid the GL_TRIANGLE_FAN
+    // and GL_TRIANGLE_STRIP and reduce the amount of possible cases
+    // outside of this library
+    //
+    // the GLU strips are short and in sweep order; when strips are
+    // requested, mesh::optimize() builds better ones from the triangles
+    //
+    snapdev::NOT_USED(edge, impl);
+}
+
+
+void font_impl::tess_callback_begin(GLenum type, font_impl * impl)
+{
+    if(type != GL_TRIANGLES)
+    {
+        throw std::runtime_error("we expected the type of the tessellation to be GL_TRIANGLES");
+    }
+
+    impl->callback_begin();
+}
+
+
+void font_impl::tess_callback_vertex(GLdouble const * vertex, font_impl * impl)
+{
+    impl->callback_vertex(point(vertex[0], vertex[1]));
+}
+
+
+void font_impl::tess_callback_combine(
+          GLdouble vertex[3]
+        , GLdouble * vertex_data[4]
+        , GLfloat weight[4]
+        , GLdouble ** out_data
+        , font_impl * impl)
+{
+    snapdev::NOT_USED(vertex_data, weight);
+
+    point::pointer_t p(impl->callback_combine(point(vertex[0], vertex[1])));
+    *out_data = p->f_coordinates;
+    //const FTGL_DOUBLE* vertex = static_cast<const FTGL_DOUBLE*>(coords);
+    //*outData = const_cast<FTGL_DOUBLE*>(mesh->Combine(vertex[0], vertex[1], vertex[2]));
+}
+
+
+void font_impl::tess_callback_end(font_impl * impl)
+{
+    impl->callback_end();
+}
+
+
+void font_impl::tess_callback_error(GLenum error_code, font_impl * impl)
+{
+    impl->callback_error(error_code);
+}
+
+
+void font_impl::callback_error(GLenum error_code)
+{
+    snapdev::NOT_USED(error_code);
+}
+
+
+void font_impl::callback_begin()
+{
+    f_current_mesh->begin();
+}
+
+
+void font_impl::callback_end()
+{
+    f_current_mesh->end();
+}
+
+
+void font_impl::callback_vertex(point const & p)
+{
+    f_current_mesh->add_point(point(p.x() / f_precision, p.y() / f_precision));
+}
+
+
+point::pointer_t font_impl::callback_combine(point const & p)
+{
+    // the temporary vertex is used to have points that are allocated
+    // and do not move in memory while building the mesh, once done
+    // they get deleted
+    //
+    // WARNING: the same pointers are reused between glyphs, in other words
+    //          the tessellation is not thread safe at all (but at least we
+    //          avoid many alloc/free/re-alloc/re-free/...)
+    //
+    if(f_temporary_vertex_pos < f_temporary_vertex.size())
+    {
+        *f_temporary_vertex[f_temporary_vertex_pos] = p;
+    }
+    else
+    {
+        f_temporary_vertex.push_back(std::make_shared<point>(p));
+    }
+
+    point::pointer_t result(f_temporary_vertex[f_temporary_vertex_pos]);
+
+    ++f_temporary_vertex_pos;
+
+    return result;
+}
+
+
+
+
+}
+
+
+
+
+///////////
+// ftfont
+
+/** \brief Create a font.
+ *
+ * By default, the font file is opened immediately. A process which
+ * registers many fonts but only uses a few of them can instead use
+ * open_mode_t::OPEN_MODE_LAZY so the file only gets opened the first
+ * time a mesh, a kerning or a metric is requested. The settings
+ * (size, precision, etc.) can be changed without opening the file.
+ *
+ * With open_mode_t::OPEN_MODE_PREFETCH, the file is opened by a
+ * background thread so it is likely ready by the time it gets used
+ * without delaying the caller.
+ *
+ * \exception std::runtime_error
+ * The file could not be opened or is not a supported font. With the
+ * lazy and prefetch modes, this error is raised by the first function
+ * which needs the file instead.
+ *
+ * \param[in] filename  The name of the font file.
+ * \param[in] mode  When to open the file.
+ */
+font::font(std::string const & filename, open_mode_t mode)
+    : font(filename, DEFAULT_FACE_INDEX, mode)
+{
+}
+
+
+/** \brief Create a font from one face of a font collection.
+ *
+ * Font collections (.ttc and .otc files) include several faces. This
+ * constructor opens the face at \p face_index. The file is mapped in
+ * memory once however many of its faces get opened. To also share the
+ * meshes of the glyphs common to several faces, use a font_collection.
+ *
+ * \exception std::out_of_range
+ * The \p face_index is negative.
+ * \exception std::runtime_error
+ * The file could not be opened or does not include that face.
+ *
+ * \param[in] filename  The name of the font file.
+ * \param[in] face_index  The index of the face, 0 for the first face.
+ * \param[in] mode  When to open the file.
+ */
+font::font(std::string const & filename, int face_index, open_mode_t mode)
+    : f_impl(std::make_shared<detail::font_impl>(filename, face_index, mode))
+{
+}
+
+
+/** \brief Check whether the font file was opened.
+ *
+ * This is always true for fonts created with the immediate open mode.
+ *
+ * \return true if the font file is open.
+ */
+bool font::is_open() const
+{
+    return f_impl->is_open();
+}
+
+
+/** \brief Set the number of unused faces kept open.
+ *
+ * Fonts opening the same file share the same FreeType face. Once no
+ * font uses a face anymore, it is kept open in case another font opens
+ * the same file again. This function sets how many such idle faces are
+ * kept. When more faces are idle, the least recently used ones get
+ * closed.
+ *
+ * \param[in] max_idle_faces  The maximum number of idle faces.
+ */
+void font::set_max_idle_faces(std::size_t max_idle_faces)
+{
+    detail::face_registry::get_instance()->set_max_idle_faces(max_idle_faces);
+}
+
+
+/** \brief Close all the faces which are not currently used.
+ *
+ * This releases the memory of the faces and unmaps the font files no
+ * longer used by any font.
+ */
+void font::close_idle_faces()
+{
+    detail::face_registry::get_instance()->close_idle_faces();
+}
+
+
+void font::set_precision(int precision)
+{
+    f_impl->set_precision(precision);
+}
+
+
+void font::set_size(int point, int x_resolution, int y_resolution)
+{
+    f_impl->set_size(point, x_resolution, y_resolution);
+}
+
+
+void font::set_simplify_tolerance(double tolerance)
+{
+    f_impl->set_simplify_tolerance(tolerance);
+}
+
+
+void font::set_mesh_format(mesh_format_t format)
+{
+    f_impl->set_mesh_format(format);
+}
+
+
+void font::set_reuse_composites(bool reuse)
+{
+    f_impl->set_reuse_composites(reuse);
+}
+
+
+/** \brief Select how FreeType loads the glyphs.
+ *
+ * By default, the glyphs are loaded with FT_LOAD_DEFAULT: the outlines
+ * get hinted for the current size and an embedded bitmap may be used
+ * instead of the outline, in which case the glyph can't be tessellated.
+ *
+ * The meshes are scalable so the hinting mostly wastes time:
+ *
+ * \li LOAD_FLAG_NO_HINTING -- load the scaled outline as is; this is the
+ * fastest and the meshes of different sizes are proportional;
+ * \li LOAD_FLAG_TARGET_LIGHT -- only apply the light (vertical) hinting;
+ * ignored along LOAD_FLAG_NO_HINTING;
+ * \li LOAD_FLAG_NO_BITMAP -- ignore the embedded bitmaps and always load
+ * the outline.
+ *
+ * The meshes of each set of flags are cached separately.
+ *
+ * \exception std::runtime_error
+ * The \p flags include unknown bits.
+ *
+ * \param[in] flags  A combination of the LOAD_FLAG_... values.
+ */
+void font::set_load_flags(load_flags_t flags)
+{
+    if(f_impl->set_load_flags(flags))
+    {
+        f_map.clear();
+    }
+}
+
+
+/** \brief Get the flags used to load the glyphs.
+ *
+ * \return The flags last set with set_load_flags().
+ */
+load_flags_t font::get_load_flags() const
+{
+    return f_impl->get_load_flags();
+}
+
+
+void font::set_slab_storage(bool use_slab)
+{
+    f_impl->set_slab_storage(use_slab);
+}
+
+
+
+mesh::pointer_t font::get_mesh(char32_t glyph)
+{
+    if(f_usage_profile != nullptr)
+    {
+        f_usage_profile->record_glyph(glyph);
+    }
+
+    auto it(f_map.find(glyph));
+    if(it != f_map.end())
+    {
+        return it->second;
+    }
+
+    // not yet cached, build the mesh now
+    //
+    mesh::pointer_t result(f_impl->get_mesh(glyph));
+    f_map[glyph] = result;
+
+    return result;
+}
+
+
+/** \brief Get the mesh of a glyph from its index.
+ *
+ * When the text was shaped by another library, the glyphs are known by
+ * their FreeType index instead of a character. This function returns
+ * the mesh of such a glyph without going back to a code point. The
+ * meshes are shared with get_mesh().
+ *
+ * \param[in] index  The FreeType glyph index.
+ *
+ * \return The mesh of that glyph or nullptr if it can't be loaded or
+ * \p index is out of range.
+ */
+mesh::pointer_t font::get_mesh_by_index(std::uint32_t index)
+{
+    return f_impl->get_mesh_by_glyph_index(index);
+}
+
+
+/** \brief Get a mesh in the background.
+ *
+ * This function returns immediately. If the mesh of \p glyph is not
+ * yet available, it gets generated by a background thread and the
+ * returned future becomes ready once done.
+ *
+ * Once ready, the mesh is also returned by get_mesh() without delay.
+ *
+ * The font stops its background thread when destroyed. The futures of
+ * the glyphs which were still queued at that time hold a
+ * std::runtime_error instead of a mesh. Errors while generating the
+ * mesh (i.e. the font file of a lazy font is missing) are also reported
+ * through the future.
+ *
+ * \param[in] glyph  The character to retrieve.
+ *
+ * \return A future holding the mesh, which may be nullptr if the glyph
+ * can't be loaded.
+ */
+std::shared_future<mesh::pointer_t> font::get_mesh_async(char32_t glyph)
+{
+    auto it(f_map.find(glyph));
+    if(it != f_map.end())
     {
-        SNAP_LOG_ERROR
-            << "FT_Set_Char_Size() failed with error #"
-            << e
-            << " for point: "
-            << point_size * f_precision
-            << " (including the upscaling), horizontal resolution: "
-            << x_resolution
-            << ", vertical resolution: "
-            << y_resolution
-            << SNAP_LOG_SEND;
+        std::promise<mesh::pointer_t> ready;
+        ready.set_value(it->second);
+        return ready.get_future().share();
+    }
+
+    return f_impl->get_mesh_async(glyph);
+}
+
+
+/** \brief Set a function called each time a background mesh is ready.
+ *
+ * The callback receives the character and its mesh. It can be used to
+ * convert a string again once its placeholders can be replaced.
+ *
+ * \warning
+ * The callback is called from the background thread. It must not call
+ * functions of this font other than get_mesh_async(). It is called
+ * before the future of that glyph becomes ready.
+ *
+ * \param[in] callback  The function to call.
+ */
+void font::set_mesh_ready_callback(mesh_ready_t callback)
+{
+    f_impl->set_mesh_ready_callback(callback);
+}
+
+
+/** \brief Let convert_string() use placeholders.
+ *
+ * By default, convert_string() waits for each mesh to be tessellated.
+ * When a string includes many characters never used before, this can
+ * take a while. With placeholders turned on, the missing meshes are
+ * generated in the background and convert_string() uses a quad
+ * covering the bounding box of the glyph instead (see
+ * mesh::is_placeholder()). The advances are the same, so the layout of
+ * the string does not change once the real meshes are available.
+ *
+ * \param[in] use_placeholders  Whether to use placeholders.
+ */
+void font::set_placeholders(bool use_placeholders)
+{
+    f_placeholders = use_placeholders;
+}
+
+
+/** \brief Get the mesh of a glyph or a placeholder.
+ *
+ * \param[in] glyph  The character to retrieve.
+ *
+ * \return The mesh, a placeholder, or nullptr.
+ */
+mesh::pointer_t font::find_mesh(char32_t glyph)
+{
+    if(f_usage_profile != nullptr)
+    {
+        f_usage_profile->record_glyph(glyph);
+    }
+
+    auto it(f_map.find(glyph));
+    if(it != f_map.end())
+    {
+        return it->second;
+    }
+
+    mesh::pointer_t result(f_impl->find_mesh(glyph));
+    if(result != nullptr
+    && !result->is_placeholder())
+    {
+        f_map[glyph] = result;
+    }
+    return result;
+}
+
+
+/** \brief Call \p callback for each glyph read by \p reader.
+ *
+ * This function reads one code point ahead so it can compute the
+ * kerning between the current and the next character. It retrieves
+ * the mesh of each character and calls \p callback with the mesh,
+ * the advance (which includes the kerning) and the code point.
+ *
+ * Characters without a mesh are skipped.
+ *
+ * When \p placeholders is true, the meshes which are not ready yet are
+ * generated in the background and a placeholder is passed to the
+ * \p callback instead (see set_placeholders()).
+ *
+ * \param[in] reader  The object returning the code points one by one.
+ * \param[in] callback  The function called with each mesh, advance and
+ * code point.
+ * \param[in] placeholders  Whether placeholders can be used.
+ */
+template<typename F>
+void font::for_each_glyph(detail::code_point_reader & reader, F callback, bool placeholders)
+{
+    char32_t current(U'\0');
+    if(!reader.next(current))
+    {
+        return;
+    }
+
+    bool more(true);
+    do
+    {
+        char32_t following(U'\0');
+        more = reader.next(following);
+
+        mesh::pointer_t m(placeholders ? find_mesh(current) : get_mesh(current));
+        if(m != nullptr)
+        {
+            float advance(m->get_advance());
+            if(more)
+            {
+                advance += get_kerning(current, following);
+            }
+            callback(m, advance, current);
+        }
+
+        current = following;
+    }
+    while(more);
+}
+
+
+/** \brief Record the characters and pairs of a cached string.
+ *
+ * A string found in the string cache does not go through get_mesh()
+ * and get_kerning() so its usage gets recorded here instead, the same
+ * way for_each_glyph() would have recorded it.
+ *
+ * \param[in] message  The string found in the cache.
+ */
+void font::record_usage(std::string_view message)
+{
+    if(f_usage_profile == nullptr)
+    {
+        return;
+    }
+
+    detail::code_point_reader reader(message);
+    char32_t current(U'\0');
+    if(!reader.next(current))
+    {
+        return;
+    }
+
+    f_usage_profile->record_glyph(current);
+    char32_t following(U'\0');
+    while(reader.next(following))
+    {
+        f_usage_profile->record_glyph(following);
+        f_usage_profile->record_pair(current, following);
+        current = following;
+    }
+}
+
+
+/** \brief Convert a UTF-8 string to a list of meshes.
+ *
+ * When the string cache is enabled (see set_string_cache_size()), the
+ * result is saved in the cache and the next call with the same string
+ * and settings returns the same object. This is why the returned string
+ * is read-only.
+ *
+ * \param[in] message  The string to convert.
+ *
+ * \return The meshes and advances of the characters of \p message.
+ */
+mesh_string::const_pointer_t font::convert_string(std::string_view message)
+{
+    if(f_impl->get_string_cache().get_max_size() == 0)
+    {
+        detail::code_point_reader reader(message);
+        return convert_string(reader);
+    }
+
+    return convert_cached_string(f_impl->get_string_key(message), message);
+}
+
+
+mesh_string::const_pointer_t font::convert_string(std::u32string_view message)
+{
+    if(f_impl->get_string_cache().get_max_size() == 0)
+    {
+        detail::code_point_reader reader(message);
+        return convert_string(reader);
+    }
+
+    // the UTF-8 message is the end of the key
+    //
+    std::string_view const key(f_impl->get_string_key(message));
+    return convert_cached_string(key, key.substr(f_impl->get_settings_key().size()));
+}
+
+
+/** \brief Convert a string using the string cache.
+ *
+ * The \p key and \p message are views on a buffer in f_impl. They
+ * remain valid here because nothing below builds another key.
+ *
+ * \param[in] key  The string cache key of \p message.
+ * \param[in] message  The UTF-8 string to convert.
+ *
+ * \return The meshes and advances of the characters of \p message.
+ */
+mesh_string::const_pointer_t font::convert_cached_string(std::string_view key, std::string_view message)
+{
+    mesh_string::const_pointer_t result(f_impl->get_string_cache().find_string(key));
+    if(result == nullptr)
+    {
+        detail::code_point_reader reader(message);
+        result = convert_string(reader);
+
+        // do not cache a string until all of its meshes are ready
+        //
+        if(std::none_of(
+                  result->begin()
+                , result->end()
+                , [](mesh_char::pointer_t const & c)
+                  {
+                      return c->get_mesh()->is_placeholder();
+                  }))
+        {
+            f_impl->get_string_cache().add_string(key, result);
+        }
+    }
+    else
+    {
+        record_usage(message);
+    }
+    return result;
+}
+
+
+mesh_string::pointer_t font::convert_string(detail::code_point_reader & reader)
+{
+    mesh_string::pointer_t result(std::make_shared<mesh_string>());
+
+    for_each_glyph(reader, [&result](mesh::pointer_t const & m, float advance, char32_t code_point)
+        {
+            result->add_glyph(m, advance, code_point);
+        }, f_placeholders);
+
+    return result;
+}
+
+
+/** \brief Compute the width of a UTF-8 string.
+ *
+ * When the string cache is enabled, the width is searched in the cache
+ * first. It is found there whether the string was passed to this
+ * function or to convert_string() before.
+ *
+ * \param[in] message  The string to measure.
+ *
+ * \return The sum of the advances of the characters of \p message.
+ */
+float font::string_width(std::string_view message)
+{
+    if(f_impl->get_string_cache().get_max_size() == 0)
+    {
+        detail::code_point_reader reader(message);
+        return string_width(reader);
+    }
+
+    return cached_string_width(f_impl->get_string_key(message), message);
+}
+
+
+float font::string_width(std::u32string_view message)
+{
+    if(f_impl->get_string_cache().get_max_size() == 0)
+    {
+        detail::code_point_reader reader(message);
+        return string_width(reader);
+    }
+
+    // the UTF-8 message is the end of the key
+    //
+    std::string_view const key(f_impl->get_string_key(message));
+    return cached_string_width(key, key.substr(f_impl->get_settings_key().size()));
+}
+
+
+/** \brief Compute the width of a string using the string cache.
+ *
+ * \param[in] key  The string cache key of \p message.
+ * \param[in] message  The UTF-8 string to measure.
+ *
+ * \return The sum of the advances of the characters of \p message.
+ */
+float font::cached_string_width(std::string_view key, std::string_view message)
+{
+    float result(0.0f);
+    if(!f_impl->get_string_cache().find_width(key, result))
+    {
+        detail::code_point_reader reader(message);
+        result = string_width(reader);
+        f_impl->get_string_cache().add_width(key, result);
+    }
+    else
+    {
+        record_usage(message);
+    }
+    return result;
+}
+
+
+/** \brief Enable the string cache.
+ *
+ * Labels which get converted over and over (buttons, axis ticks,
+ * numbers) can be cached. The cache is keyed by the UTF-8 bytes of
+ * the string and the current settings of the font so a cached string
+ * is only returned when it would be converted the same way. Both
+ * convert_string() and string_width() use the cache.
+ *
+ * The \p max_size parameter is an estimate, in bytes, of the memory the
+ * cache can use. The meshes are not included since they are shared
+ * with the font. Once full, the least recently used strings get
+ * removed. A size of 0, the default, disables the cache.
+ *
+ * \param[in] max_size  The maximum size of the cache in bytes.
+ */
+void font::set_string_cache_size(std::size_t max_size)
+{
+    f_impl->get_string_cache().set_max_size(max_size);
+}
+
+
+/** \brief Get the estimated memory used by the string cache.
+ *
+ * \return The number of bytes used by the string cache.
+ */
+std::size_t font::get_string_cache_usage() const
+{
+    return f_impl->get_string_cache().get_size();
+}
+
+
+void font::clear_string_cache()
+{
+    f_impl->get_string_cache().clear();
+}
+
+
+/** \brief Share the meshes with other processes.
+ *
+ * Processes running on the same computer and using the same fonts can
+ * share their meshes through a named shared memory segment. The first
+ * process which needs a glyph tessellates it and saves it in the
+ * segment. The other processes copy it from there instead of
+ * tessellating it again.
+ *
+ * The meshes are identified by the font filename, the settings of the
+ * font and the glyph index, so fonts with different settings can use
+ * the same segment. All the processes must use the same \p size.
+ *
+ * The segment is not removed when the processes exit. Use
+ * shm_unlink() to remove it. A segment left uninitialized by a process
+ * which died while creating it gets removed and created again.
+ *
+ * \exception std::runtime_error
+ * The segment could not be created or opened.
+ *
+ * \param[in] name  The name of the shared memory segment, as in
+ * "/ftmesh-cache", or an empty string to stop using the shared cache.
+ * \param[in] size  The size of the segment in bytes.
+ */
+void font::set_shared_cache(std::string const & name, std::size_t size)
+{
+    f_impl->set_shared_cache(name, size);
+}
+
+
+void font::set_outline_cache(std::shared_ptr<detail::outline_cache> cache)
+{
+    f_impl->set_outline_cache(cache);
+}
+
+
+float font::string_width(detail::code_point_reader & reader)
+{
+    float result(0.0f);
+
+    for_each_glyph(reader, [&result](mesh::pointer_t const & m, float advance, char32_t code_point)
+        {
+            snapdev::NOT_USED(m, code_point);
+            result += advance;
+        });
+
+    return result;
+}
+
+
+mesh_string::pointer_t font::truncate_string(
+      std::string_view message
+    , float max_width
+    , char32_t ellipsis)
+{
+    detail::code_point_reader reader(message);
+    return truncate_string(reader, max_width, ellipsis);
+}
+
+
+mesh_string::pointer_t font::truncate_string(
+      std::u32string_view message
+    , float max_width
+    , char32_t ellipsis)
+{
+    detail::code_point_reader reader(message);
+    return truncate_string(reader, max_width, ellipsis);
+}
+
+
+/** \brief Convert a string and truncate it to fit \p max_width.
+ *
+ * When the whole string fits, this function returns the same result as
+ * convert_string(). Otherwise the string is cut and the \p ellipsis
+ * character is appended so the result fits in \p max_width.
+ *
+ * The number of characters which fit is found with a binary search on
+ * the advances computed by convert_string(). Only the advance of the
+ * last character kept is recalculated since its kerning is now with
+ * the ellipsis.
+ *
+ * If even the ellipsis alone does not fit, the result is the ellipsis.
+ *
+ * \param[in] reader  The reader returning the characters to convert.
+ * \param[in] max_width  The maximum width of the result.
+ * \param[in] ellipsis  The character appended to a truncated string.
+ *
+ * \return The converted string.
+ */
+mesh_string::pointer_t font::truncate_string(
+      detail::code_point_reader & reader
+    , float max_width
+    , char32_t ellipsis)
+{
+    mesh_string::pointer_t full(convert_string(reader));
+    if(full->get_width() <= max_width)
+    {
+        return full;
+    }
+
+    mesh::pointer_t ellipsis_mesh(get_mesh(ellipsis));
+    float const ellipsis_width(ellipsis_mesh == nullptr
+                                    ? 0.0f
+                                    : ellipsis_mesh->get_advance());
+
+    // the kerning with the ellipsis may make the last character wider
+    // than it was in the full string, if so, drop one more character
+    //
+    std::size_t count(full->fit_width(max_width - ellipsis_width));
+    float last_advance(0.0f);
+    while(count > 0)
+    {
+        mesh_char::pointer_t const & last((*full)[count - 1]);
+        last_advance = last->get_mesh()->get_advance()
+                     + get_kerning(last->get_code_point(), ellipsis);
+        if(full->get_caret_position(count - 1) + last_advance + ellipsis_width <= max_width)
+        {
+            break;
+        }
+        --count;
+    }
+
+    mesh_string::pointer_t result(std::make_shared<mesh_string>());
+    result->reserve(count + 1);
+    for(std::size_t idx(0); idx < count; ++idx)
+    {
+        mesh_char::pointer_t const & c((*full)[idx]);
+        result->add_glyph(
+                  c->get_mesh()
+                , idx + 1 == count ? last_advance : c->get_advance()
+                , c->get_code_point());
+    }
+    if(ellipsis_mesh != nullptr)
+    {
+        result->add_glyph(ellipsis_mesh, ellipsis_width, ellipsis);
+    }
+
+    return result;
+}
+
+
+/** \brief Get the kerning between two characters.
+ *
+ * This is the amount to add to the advance of \p current_char when it
+ * is followed by \p next_char. It is 0 when the font has no kerning
+ * information for that pair.
+ *
+ * \param[in] current_char  The character on the left.
+ * \param[in] next_char  The character on the right.
+ *
+ * \return The kerning adjustment.
+ */
+float font::get_kerning(char32_t current_char, char32_t next_char)
+{
+    if(f_usage_profile != nullptr)
+    {
+        f_usage_profile->record_pair(current_char, next_char);
     }
+
+    return f_impl->get_kerning(current_char, next_char);
 }
 
 
-float font_impl::get_kerning(char32_t current_char, char32_t next_char)
+/** \brief Get the kerning between two glyphs from their index.
+ *
+ * This is the same as get_kerning() for glyphs known by their FreeType
+ * index. Only the legacy kerning table is used. A shaper already
+ * includes the kerning in the advances it returns.
+ *
+ * \param[in] current_index  The index of the glyph on the left.
+ * \param[in] next_index  The index of the glyph on the right.
+ *
+ * \return The kerning adjustment.
+ */
+float font::get_kerning_by_index(std::uint32_t current_index, std::uint32_t next_index)
 {
-    FT_Vector kern_advance = FT_Vector();
+    return f_impl->get_kerning_by_index(current_index, next_index);
+}
 
-    //if(has_kerning_table()) -- TBD
+
+/** \brief Position glyphs which were already shaped.
+ *
+ * This function converts the output of a shaper in a list of positioned
+ * glyphs. Each glyph gets drawn at the pen position plus its offset
+ * and then the pen moves by its advance. The advances and offsets must
+ * be in the same units as the meshes (i.e. the advance of a mesh).
+ *
+ * Glyphs which can't be loaded still move the pen but are not included
+ * in the result.
+ *
+ * \param[in] glyphs  The shaped glyphs.
+ * \param[in] x  The horizontal position of the first glyph.
+ * \param[in] y  The vertical position of the first glyph.
+ *
+ * \return The glyphs with their mesh and position.
+ */
+positioned_glyph::vector_t font::convert_glyphs(
+          shaped_glyph::vector_t const & glyphs
+        , float x
+        , float y)
+{
+    positioned_glyph::vector_t result;
+    result.reserve(glyphs.size());
+    for(auto const & g : glyphs)
     {
-        FT_UInt const current_index(FT_Get_Char_Index(f_face, current_char));
-        FT_UInt const next_index(FT_Get_Char_Index(f_face, next_char));
-        int const e(FT_Get_Kerning(
-                  f_face
-                , current_index
-                , next_index
-                , FT_KERNING_UNFITTED
-                , &kern_advance));
-        if(e != FT_Err_Ok)
+        mesh::pointer_t m(get_mesh_by_index(g.f_index));
+        if(m != nullptr)
         {
-            // this is probably common?
+            positioned_glyph p;
+            p.f_mesh = m;
+            p.f_code_point = g.f_code_point;
+            p.f_x = x + g.f_x_offset;
+            p.f_y = y + g.f_y_offset;
+            result.push_back(p);
         }
+        x += g.f_x_advance;
+        y += g.f_y_advance;
     }
 
-    return static_cast<float>(kern_advance.x) / static_cast<float>(f_precision);
+    return result;
 }
 
 
-void font_impl::tess_callback_edge(GLboolean edge, font_impl * impl)
+/** \brief Check whether shape() uses HarfBuzz.
+ *
+ * The library can be compiled without HarfBuzz in which case shape()
+ * only applies the legacy kerning table.
+ *
+ * \return true if the library was compiled with HarfBuzz.
+ */
+bool font::has_shaping()
 {
-    // we have this callback to force the GLU library to only create
-    // triangles (GL_TRIANGLES); that way we avoid the GL_TRIANGLE_FAN
-    // and GL_TRIANGLE_STRIP and reduce the amount of possible cases
-    // outside of this library
-    //
-    snapdev::NOT_USED(edge, impl);
+#ifdef FTMESH_HARFBUZZ
+    return true;
+#else
+    return false;
+#endif
 }
 
 
-void font_impl::tess_callback_begin(GLenum type, font_impl * impl)
+/** \brief Shape a string.
+ *
+ * This function converts the characters of \p message to glyphs using
+ * HarfBuzz. Contrary to convert_string(), which only applies the legacy
+ * 'kern' table, this applies the OpenType features of the font: GPOS
+ * kerning, ligatures, marks positioning, contextual forms, etc. The
+ * script, language and direction are guessed from the text.
+ *
+ * The result can be converted to meshes with convert_glyphs(). The
+ * glyphs are fed by index directly in the mesh cache.
+ *
+ * The shape plans are cached by the font and each thread reuses its
+ * own HarfBuzz buffer.
+ *
+ * When the library was compiled without HarfBuzz (see has_shaping()),
+ * each character becomes one glyph positioned using the kerning table
+ * as convert_string() does.
+ *
+ * \param[in] message  The UTF-8 string to shape.
+ *
+ * \return The shaped glyphs.
+ */
+shaped_glyph::vector_t font::shape(std::string_view message)
 {
-    if(type != GL_TRIANGLES)
+    // HarfBuzz clusters are offsets in the buffer, decoding the UTF-8
+    // ourselves gives us code point offsets
+    //
+    detail::code_point_reader reader(message);
+    std::u32string text;
+    text.reserve(reader.size_hint());
+    char32_t c(U'\0');
+    while(reader.next(c))
     {
-        throw std::runtime_error("we expected the type of the tessellation to be GL_TRIANGLES");
+        text += c;
     }
-
-    impl->callback_begin();
+    return f_impl->shape(text);
 }
 
 
-void font_impl::tess_callback_vertex(GLdouble const * vertex, font_impl * impl)
+/** \brief Shape a string.
+ *
+ * See the UTF-8 version of this function for details.
+ *
+ * \param[in] message  The UTF-32 string to shape.
+ *
+ * \return The shaped glyphs.
+ */
+shaped_glyph::vector_t font::shape(std::u32string_view message)
 {
-    impl->callback_vertex(point(vertex[0], vertex[1]));
+    return f_impl->shape(message);
 }
 
 
-void font_impl::tess_callback_combine(
-          GLdouble vertex[3]
-        , GLdouble * vertex_data[4]
-        , GLfloat weight[4]
-        , GLdouble ** out_data
-        , font_impl * impl)
+/** \brief Record the characters and kerning pairs used by this font.
+ *
+ * Once a profile is set, each call to get_mesh() and get_kerning(),
+ * including the calls made when converting strings, increments the
+ * count of the character or pair in \p profile. Strings found in the
+ * string cache get counted as if they had been converted again. The profile can then
+ * be saved and used at the next start to prewarm() the font.
+ *
+ * Use a null pointer to stop recording.
+ *
+ * \param[in] profile  The profile where the usage gets recorded.
+ */
+void font::set_usage_profile(usage_profile::pointer_t profile)
 {
-    snapdev::NOT_USED(vertex_data, weight);
-
-    point::pointer_t p(impl->callback_combine(point(vertex[0], vertex[1])));
-    *out_data = p->f_coordinates;
-    //const FTGL_DOUBLE* vertex = static_cast<const FTGL_DOUBLE*>(coords);
-    //*outData = const_cast<FTGL_DOUBLE*>(mesh->Combine(vertex[0], vertex[1], vertex[2]));
+    f_usage_profile = profile;
 }
 
 
-void font_impl::tess_callback_end(font_impl * impl)
+usage_profile::pointer_t font::get_usage_profile() const
 {
-    impl->callback_end();
+    return f_usage_profile;
 }
 
 
-void font_impl::tess_callback_error(GLenum error_code, font_impl * impl)
+/** \brief Generate the meshes listed in a profile in the background.
+ *
+ * The characters of \p profile are queued to the background worker,
+ * the most used first, followed by the kerning pairs. This function
+ * returns immediately. The meshes are then available without delay
+ * once generated. See get_mesh_async().
+ *
+ * \param[in] profile  The profile listing the characters to generate.
+ * \param[in] max_count  The maximum number of characters and of pairs
+ * to generate, 0 for all of them.
+ */
+void font::prewarm(usage_profile::pointer_t profile, std::size_t max_count)
 {
-    impl->callback_error(error_code);
+    for(auto const & g : profile->get_glyphs(max_count))
+    {
+        if(f_map.find(g.f_glyph) == f_map.end())
+        {
+            f_impl->get_mesh_async(g.f_glyph);
+        }
+    }
+    for(auto const & p : profile->get_pairs(max_count))
+    {
+        f_impl->prewarm_kerning(p.f_current, p.f_next);
+    }
 }
 
 
-void font_impl::callback_error(GLenum error_code)
+float font::get_line_height() const
 {
-    snapdev::NOT_USED(error_code);
+    return f_impl->get_line_height();
 }
 
 
-void font_impl::callback_begin()
+/** \brief Get the list of characters supported by this font.
+ *
+ * The characters are read from the charmap of the face. The other
+ * functions of this font return the "missing glyph" (often a box)
+ * for characters not in this list.
+ *
+ * \return The characters in increasing order.
+ */
+std::u32string font::get_characters() const
 {
-    f_current_mesh->begin();
+    return f_impl->get_characters();
 }
 
 
-void font_impl::callback_end()
+/** \brief Get the axes of a variable font.
+ *
+ * Each axis has a name, a tag (i.e. 'wght' for the weight) and a range
+ * of design coordinates with a default.
+ *
+ * \return The variation axes, an empty vector if this font is not a
+ * variable font.
+ */
+variation_axis::vector_t font::get_variation_axes() const
 {
-    f_current_mesh->end();
+    return f_impl->get_variation_axes();
 }
 
 
-void font_impl::callback_vertex(point const & p)
+/** \brief Get the named instances of a variable font.
+ *
+ * A named instance, such as "Bold" or "Condensed Light", is a set of
+ * design coordinates chosen by the font designer. Its coordinates can
+ * be passed to set_variation().
+ *
+ * \return The named instances, an empty vector if this font is not a
+ * variable font.
+ */
+named_instance::vector_t font::get_named_instances() const
 {
-    f_current_mesh->add_point(point(p.x() / f_precision, p.y() / f_precision));
+    return f_impl->get_named_instances();
 }
 
 
-point::pointer_t font_impl::callback_combine(point const & p)
+/** \brief Select the variation of a variable font.
+ *
+ * The \p coordinates are the design coordinates of each axis, in the
+ * order returned by get_variation_axes(). Missing coordinates use the
+ * default of their axis and coordinates out of range get clamped. An
+ * empty vector selects the defaults.
+ *
+ * Each set of coordinates has its own meshes, so switching back to
+ * coordinates used before does not tessellate anything again. To limit
+ * the number of sets while animating an axis, the coordinates are
+ * rounded to a multiple of the variation step (see
+ * set_variation_step()) and, optionally, snapped to the nearest named
+ * instance (see set_snap_to_named_instances()). The meshes of at most
+ * MAX_VARIANT_CACHES sets of coordinates and synthetic styles are kept;
+ * the least recently used set gets dropped first.
+ *
+ * The meshes requested with get_mesh_async() before this call may be
+ * generated with the new coordinates.
+ *
+ * \exception std::logic_error
+ * Coordinates were specified but this font is not a variable font.
+ * \exception std::out_of_range
+ * There are more coordinates than axes.
+ *
+ * \param[in] coordinates  The design coordinates.
+ */
+void font::set_variation(std::vector<double> const & coordinates)
 {
-    // the temporary vertex is used to have points that are allocated
-    // and do not move in memory while building the mesh, once done
-    // they get deleted
-    //
-    // WARNING: the same pointers are reused between glyphs, in other words
-    //          the tessellation is not thread safe at all (but at least we
-    //          avoid many alloc/free/re-alloc/re-free/...)
-    //
-    if(f_temporary_vertex_pos < f_temporary_vertex.size())
-    {
-        *f_temporary_vertex[f_temporary_vertex_pos] = p;
-    }
-    else
+    if(f_impl->set_variation(coordinates))
     {
-        f_temporary_vertex.push_back(std::make_shared<point>(p));
+        f_map.clear();
     }
-
-    point::pointer_t result(f_temporary_vertex[f_temporary_vertex_pos]);
-
-    ++f_temporary_vertex_pos;
-
-    return result;
 }
 
 
-
-
+/** \brief Get the variation coordinates in use.
+ *
+ * The coordinates are the ones actually used to generate the meshes,
+ * after rounding and snapping.
+ *
+ * \return The design coordinates, an empty vector if this font is not
+ * a variable font.
+ */
+std::vector<double> font::get_variation() const
+{
+    return f_impl->get_variation();
 }
 
 
-
-
-///////////
-// ftfont
-
-font::font(std::string const & filename)
-    : f_impl(std::make_shared<detail::font_impl>(filename))
+/** \brief Set the step used to round the variation coordinates.
+ *
+ * The coordinates passed to set_variation() are rounded to a multiple
+ * of \p step. An animation going through many intermediate values then
+ * tessellates each glyph at most once per step. The default is
+ * DEFAULT_VARIATION_STEP. Use 0.0 to keep the exact coordinates.
+ *
+ * The new step is used by the next call to set_variation().
+ *
+ * \exception std::runtime_error
+ * The step is negative.
+ *
+ * \param[in] step  The rounding step in design units.
+ */
+void font::set_variation_step(double step)
 {
+    f_impl->set_variation_step(step);
 }
 
 
-void font::set_precision(int precision)
+/** \brief Snap the variation coordinates to the nearest named instance.
+ *
+ * When turned on, set_variation() selects the named instance nearest to
+ * the requested coordinates. The number of sets of meshes is then at
+ * most the number of named instances.
+ *
+ * \param[in] snap  Whether to snap to named instances.
+ */
+void font::set_snap_to_named_instances(bool snap)
 {
-    f_impl->set_precision(precision);
+    f_impl->set_snap_to_named_instances(snap);
 }
 
 
-void font::set_size(int point, int x_resolution, int y_resolution)
+/** \brief Generate bold glyphs from a regular face.
+ *
+ * When a font family has no bold face, this function can be used to
+ * make the outlines thicker before they get tessellated. This looks
+ * much better than scaling the vertices of the regular meshes.
+ *
+ * The \p strength is the amount by which the outlines grow, expressed
+ * as a fraction of the em size. DEFAULT_SYNTHETIC_BOLD gives the same
+ * result as FreeType's FT_GlyphSlot_Embolden(). The advances grow by
+ * the same amount. Use 0.0, the default, to use the outlines as is.
+ *
+ * The meshes of each style are cached separately, so switching between
+ * styles does not tessellate the glyphs again. While a synthetic style
+ * is used, composite glyphs are not reused (see set_reuse_composites()).
+ *
+ * \exception std::runtime_error
+ * The \p strength is negative.
+ *
+ * \param[in] strength  The strength of the synthetic bold.
+ */
+void font::set_synthetic_bold(double strength)
 {
-    f_impl->set_size(point, x_resolution, y_resolution);
+    if(f_impl->set_synthetic_bold(strength))
+    {
+        f_map.clear();
+    }
 }
 
 
-
-mesh::pointer_t font::get_mesh(char32_t glyph)
+/** \brief Generate oblique glyphs from a regular face.
+ *
+ * When a font family has no italic face, this function can be used to
+ * shear the outlines before they get tessellated. The \p slant is the
+ * horizontal shift per unit of height; DEFAULT_SYNTHETIC_OBLIQUE gives
+ * the same 12 degrees slant as FreeType's FT_GlyphSlot_Oblique(). A
+ * negative value slants the glyphs backward. Use 0.0, the default, to
+ * use the outlines as is.
+ *
+ * Like with set_synthetic_bold(), the meshes of each style are cached
+ * separately.
+ *
+ * \param[in] slant  The slant of the synthetic oblique.
+ */
+void font::set_synthetic_oblique(double slant)
 {
-    auto it(f_map.find(glyph));
-    if(it != f_map.end())
+    if(f_impl->set_synthetic_oblique(slant))
     {
-        return it->second;
+        f_map.clear();
     }
-
-    // not yet cached, build the mesh now
-    //
-    mesh::pointer_t result(f_impl->get_mesh(glyph));
-    f_map[glyph] = result;
-
-    return result;
 }
 
 
-mesh_string::pointer_t font::convert_string(std::string const & message)
+/** \brief Convert a very large text in batches of positioned glyphs.
+ *
+ * This function reads UTF-8 text using \p reader, one chunk at a time,
+ * and calls \p callback with batches of at most \p batch_size glyphs
+ * each with its absolute position. The memory used remains the same
+ * however large the input is and the caller can start rendering before
+ * the whole input was read.
+ *
+ * The kerning between the last character of a chunk and the first
+ * character of the next chunk is applied, as are characters split
+ * between two chunks.
+ *
+ * A newline character ('\n') moves the position back to 0 and down
+ * by get_line_height(). Carriage returns ('\r') are ignored.
+ *
+ * The \p reader function is expected to fill its parameter with the
+ * next chunk and return true, or return false at the end of the input.
+ * The \p callback can return false to stop the conversion early.
+ *
+ * \exception libutf8::libutf8_exception_decoding
+ * The input is not valid UTF-8.
+ *
+ * \param[in] reader  The function reading the next chunk of text.
+ * \param[in] callback  The function receiving the batches.
+ * \param[in] batch_size  The maximum number of glyphs per batch.
+ */
+void font::convert_stream(
+      chunk_reader_t reader
+    , batch_callback_t callback
+    , std::size_t batch_size)
 {
-    mesh_string::pointer_t result(std::make_shared<mesh_string>());
+    if(batch_size == 0)
+    {
+        batch_size = 1;
+    }
+
+    float const line_height(get_line_height());
+    positioned_glyph::vector_t batch;
+    batch.reserve(batch_size);
+
+    float x(0.0f);
+    float y(0.0f);
+    bool has_previous(false);
+    char32_t previous(U'\0');
+    bool stop(false);
 
-    std::u32string const s(libutf8::to_u32string(message));
-    std::size_t const size(s.size());
-    if(size > 0)
+    // output the previous character now that we know the next one
+    //
+    auto emit_previous = [&](bool has_next, char32_t next)
     {
-        std::size_t const max(size - 1);
-        for(std::size_t i(0); i < max; ++i)
+        if(previous == U'\n')
+        {
+            x = 0.0f;
+            y -= line_height;
+        }
+        else if(previous != U'\r')
         {
-            mesh::pointer_t m(get_mesh(s[i]));
+            mesh::pointer_t m(get_mesh(previous));
             if(m != nullptr)
             {
-                float advance(m->get_advance());
-                advance += f_impl->get_kerning(s[i], s[i + 1]);
-                result->add_glyph(m, advance);
+                positioned_glyph g;
+                g.f_mesh = m;
+                g.f_code_point = previous;
+                g.f_x = x;
+                g.f_y = y;
+                batch.push_back(g);
+
+                x += m->get_advance();
+                if(has_next
+                && next != U'\n')
+                {
+                    x += get_kerning(previous, next);
+                }
             }
         }
-        mesh::pointer_t m(get_mesh(s[max]));
-        if(m != nullptr)
+
+        if(batch.size() >= batch_size)
+        {
+            stop = !callback(batch);
+            batch.clear();
+        }
+    };
+
+    std::string chunk;
+    std::string pending;
+    while(!stop && reader(chunk))
+    {
+        std::string_view data(chunk);
+        if(!pending.empty())
+        {
+            pending += chunk;
+            data = pending;
+        }
+        std::size_t const length(detail::complete_utf8_length(data));
+
+        detail::code_point_reader code_points(data.substr(0, length));
+        char32_t c(U'\0');
+        while(!stop && code_points.next(c))
         {
-            result->add_glyph(m, m->get_advance());
+            if(has_previous)
+            {
+                emit_previous(true, c);
+            }
+            previous = c;
+            has_previous = true;
         }
+
+        pending = std::string(data.substr(length));
+        chunk.clear();
     }
 
-    return result;
+    if(stop)
+    {
+        return;
+    }
+
+    if(!pending.empty())
+    {
+        throw libutf8::libutf8_exception_decoding(
+                "font::convert_stream(): the input ends with an incomplete UTF-8 character.");
+    }
+
+    if(has_previous)
+    {
+        emit_previous(false, U'\0');
+    }
+    if(!stop
+    && !batch.empty())
+    {
+        callback(batch);
+    }
 }
 
 
-float font::string_width(std::string const & message)
+/** \brief Convert the text read from a stream in batches.
+ *
+ * This function reads \p in in chunks of DEFAULT_CHUNK_SIZE bytes and
+ * calls the other convert_stream() function.
+ *
+ * \param[in] in  The input stream with UTF-8 text.
+ * \param[in] callback  The function receiving the batches.
+ * \param[in] batch_size  The maximum number of glyphs per batch.
+ */
+void font::convert_stream(
+      std::istream & in
+    , batch_callback_t callback
+    , std::size_t batch_size)
 {
-    float result(0.0f);
+    convert_stream(
+          [&in](std::string & chunk)
+          {
+              chunk.resize(DEFAULT_CHUNK_SIZE);
+              in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+              chunk.resize(static_cast<std::size_t>(in.gcount()));
+              return !chunk.empty();
+          }
+        , callback
+        , batch_size);
+}
 
-    std::u32string const s(libutf8::to_u32string(message));
-    std::size_t const size(s.size());
-    if(size > 0)
-    {
-        std::size_t const max(size - 1);
-        for(std::size_t i(0); i < max; ++i)
+
+/** \brief Get the pool holding the glyphs used by convert_instances().
+ *
+ * The pool is created the first time this function or
+ * convert_instances() gets called. It is shared with the caller which
+ * is expected to upload its vertex and element buffers to the GPU.
+ *
+ * Changing a setting affecting the meshes (i.e. set_mesh_format(),
+ * set_size(), set_variation()) starts a new pool. The previous pool
+ * remains valid for the instances it was used with but does not grow
+ * anymore, so call this function again after such a change.
+ *
+ * \return The glyph pool of this font.
+ */
+glyph_pool::pointer_t font::get_glyph_pool()
+{
+    return f_impl->get_glyph_pool();
+}
+
+
+/** \brief Convert a string to a stream of glyph instances.
+ *
+ * Instead of a mesh_string, this function returns one small instance
+ * per visible glyph: the identifier of the glyph range in the glyph
+ * pool and the position of the glyph. The meshes get added to the pool
+ * the first time they are used.
+ *
+ * Glyphs without geometry (i.e. spaces) only advance the position.
+ *
+ * \param[in] message  The UTF-8 string to convert.
+ *
+ * \return The glyph instances.
+ */
+glyph_pool::instance_vector_t font::convert_instances(std::string_view message)
+{
+    detail::code_point_reader reader(message);
+    return convert_instances(reader);
+}
+
+
+glyph_pool::instance_vector_t font::convert_instances(std::u32string_view message)
+{
+    detail::code_point_reader reader(message);
+    return convert_instances(reader);
+}
+
+
+glyph_pool::instance_vector_t font::convert_instances(detail::code_point_reader & reader)
+{
+    glyph_pool::pointer_t pool(get_glyph_pool());
+
+    glyph_pool::instance_vector_t result;
+    result.reserve(reader.size_hint());
+    float x(0.0f);
+    for_each_glyph(reader, [&](mesh::pointer_t const & m, float advance, char32_t code_point)
         {
-            mesh::pointer_t m(get_mesh(s[i]));
-            if(m != nullptr)
+            snapdev::NOT_USED(code_point);
+
+            // a placeholder gets replaced, never keep it in the pool
+            //
+            if(m->is_placeholder())
             {
-                result += m->get_advance();
-                result += f_impl->get_kerning(s[i], s[i + 1]);
+                x += advance;
+                return;
             }
-        }
-        mesh::pointer_t m(get_mesh(s[max]));
-        if(m != nullptr)
-        {
-            result += m->get_advance();
-        }
-    }
+
+            glyph_pool::range_id_t const id(pool->add_mesh(m));
+            if(pool->get_range(id).f_element_count > 0)
+            {
+                glyph_pool::instance i;
+                i.f_range = id;
+                i.f_x = x;
+                result.push_back(i);
+            }
+            x += advance;
+        });
 
     return result;
 }
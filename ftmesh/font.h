@@ -29,21 +29,63 @@
 
 // self
 //
+#include    <ftmesh/glyph_pool.h>
 #include    <ftmesh/mesh_string.h>
+#include    <ftmesh/positioned_glyph.h>
+#include    <ftmesh/shaped_glyph.h>
+#include    <ftmesh/usage_profile.h>
+#include    <ftmesh/variation.h>
+
+
+// C++
+//
+#include    <cstdint>
+#include    <functional>
+#include    <future>
+#include    <istream>
+#include    <string_view>
 
 
 namespace ftmesh
 {
 
 
+constexpr int const DEFAULT_FACE_INDEX = 0;
 constexpr int const DEFAULT_UPSCALE = 64;
 constexpr int const DEFAULT_SIZE = 12;
 constexpr int const DEFAULT_RESOLUTION = 72;
+constexpr double const DEFAULT_SIMPLIFY_TOLERANCE = 0.01;
+constexpr double const DEFAULT_VARIATION_STEP = 1.0;
+constexpr std::size_t const MAX_VARIANT_CACHES = 32;
+constexpr double const DEFAULT_SYNTHETIC_BOLD = 1.0 / 24.0;       // same as FT_GlyphSlot_Embolden()
+constexpr double const DEFAULT_SYNTHETIC_OBLIQUE = 0.21256;      // tan(12 deg.) as FT_GlyphSlot_Oblique()
+constexpr std::size_t const DEFAULT_BATCH_SIZE = 1024;
+constexpr std::size_t const DEFAULT_CHUNK_SIZE = 64 * 1024;
+constexpr std::size_t const DEFAULT_SHARED_CACHE_SIZE = 64 * 1024 * 1024;
+
+
+typedef std::uint32_t       load_flags_t;
+
+constexpr load_flags_t const LOAD_FLAG_DEFAULT = 0x0000;        // hinted, embedded bitmaps allowed
+constexpr load_flags_t const LOAD_FLAG_NO_HINTING = 0x0001;     // scaled outlines, not hinted
+constexpr load_flags_t const LOAD_FLAG_TARGET_LIGHT = 0x0002;   // light (vertical only) hinting
+constexpr load_flags_t const LOAD_FLAG_NO_BITMAP = 0x0004;      // ignore embedded bitmaps
+constexpr load_flags_t const LOAD_FLAG_ALL = 0x0007;
+
+
+enum class open_mode_t
+{
+    OPEN_MODE_IMMEDIATE,        // open the file in the constructor
+    OPEN_MODE_LAZY,             // open the file on first use
+    OPEN_MODE_PREFETCH,         // open the file in a background thread
+};
 
 
 namespace detail
 {
 class font_impl;
+class code_point_reader;
+class outline_cache;
 } // namespace details
 
 
@@ -51,18 +93,127 @@ class font
 {
 public:
     typedef std::shared_ptr<font>         pointer_t;
-
-                            font(std::string const & filename);
-
+    typedef std::function<bool(std::string & chunk)>
+                                          chunk_reader_t;
+    typedef std::function<bool(positioned_glyph::vector_t const & batch)>
+                                          batch_callback_t;
+    typedef std::function<void(char32_t glyph, mesh::pointer_t m)>
+                                          mesh_ready_t;
+
+                            font(
+                                  std::string const & filename
+                                , open_mode_t mode = open_mode_t::OPEN_MODE_IMMEDIATE);
+                            font(
+                                  std::string const & filename
+                                , int face_index
+                                , open_mode_t mode = open_mode_t::OPEN_MODE_IMMEDIATE);
+
+    static void             set_max_idle_faces(std::size_t max_idle_faces);
+    static void             close_idle_faces();
+
+    bool                    is_open() const;
     void                    set_precision(int precision);
     void                    set_size(int point, int x_resolution, int y_resolution);
+    void                    set_simplify_tolerance(double tolerance);
+    void                    set_mesh_format(mesh_format_t format);
+    void                    set_reuse_composites(bool reuse);
+    void                    set_load_flags(load_flags_t flags);
+    load_flags_t            get_load_flags() const;
+    void                    set_slab_storage(bool use_slab);
+    void                    set_string_cache_size(std::size_t max_size);
+    std::size_t             get_string_cache_usage() const;
+    void                    clear_string_cache();
+    void                    set_shared_cache(
+                                  std::string const & name
+                                , std::size_t size = DEFAULT_SHARED_CACHE_SIZE);
 
     mesh::pointer_t         get_mesh(char32_t glyph);
-    mesh_string::pointer_t  convert_string(std::string const & message);
-    float                   string_width(std::string const & message);
+    mesh::pointer_t         get_mesh_by_index(std::uint32_t index);
+    std::shared_future<mesh::pointer_t>
+                            get_mesh_async(char32_t glyph);
+    void                    set_mesh_ready_callback(mesh_ready_t callback);
+    void                    set_placeholders(bool use_placeholders);
+    void                    set_usage_profile(usage_profile::pointer_t profile);
+    usage_profile::pointer_t
+                            get_usage_profile() const;
+    void                    prewarm(usage_profile::pointer_t profile, std::size_t max_count = 0);
+    mesh_string::const_pointer_t
+                            convert_string(std::string_view message);
+    mesh_string::const_pointer_t
+                            convert_string(std::u32string_view message);
+    float                   string_width(std::string_view message);
+    float                   string_width(std::u32string_view message);
+    mesh_string::pointer_t  truncate_string(
+                                  std::string_view message
+                                , float max_width
+                                , char32_t ellipsis = U'\u2026');
+    mesh_string::pointer_t  truncate_string(
+                                  std::u32string_view message
+                                , float max_width
+                                , char32_t ellipsis = U'\u2026');
+    glyph_pool::pointer_t   get_glyph_pool();
+    glyph_pool::instance_vector_t
+                            convert_instances(std::string_view message);
+    glyph_pool::instance_vector_t
+                            convert_instances(std::u32string_view message);
+    float                   get_kerning(char32_t current_char, char32_t next_char);
+    float                   get_kerning_by_index(std::uint32_t current_index, std::uint32_t next_index);
+    static bool             has_shaping();
+    shaped_glyph::vector_t  shape(std::string_view message);
+    shaped_glyph::vector_t  shape(std::u32string_view message);
+    positioned_glyph::vector_t
+                            convert_glyphs(
+                                  shaped_glyph::vector_t const & glyphs
+                                , float x = 0.0f
+                                , float y = 0.0f);
+    float                   get_line_height() const;
+    std::u32string          get_characters() const;
+    variation_axis::vector_t
+                            get_variation_axes() const;
+    named_instance::vector_t
+                            get_named_instances() const;
+    void                    set_variation(std::vector<double> const & coordinates);
+    std::vector<double>     get_variation() const;
+    void                    set_variation_step(double step);
+    void                    set_snap_to_named_instances(bool snap);
+    void                    set_synthetic_bold(double strength);
+    void                    set_synthetic_oblique(double slant);
+    void                    convert_stream(
+                                  chunk_reader_t reader
+                                , batch_callback_t callback
+                                , std::size_t batch_size = DEFAULT_BATCH_SIZE);
+    void                    convert_stream(
+                                  std::istream & in
+                                , batch_callback_t callback
+                                , std::size_t batch_size = DEFAULT_BATCH_SIZE);
 
 private:
+    friend class font_collection;
+
+    void                    set_outline_cache(std::shared_ptr<detail::outline_cache> cache);
+    template<typename F>
+    void                    for_each_glyph(
+                                  detail::code_point_reader & reader
+                                , F callback
+                                , bool placeholders = false);
+    mesh::pointer_t         find_mesh(char32_t glyph);
+    void                    record_usage(std::string_view message);
+    mesh_string::pointer_t  convert_string(detail::code_point_reader & reader);
+    mesh_string::const_pointer_t
+                            convert_cached_string(std::string_view key, std::string_view message);
+    float                   string_width(detail::code_point_reader & reader);
+    float                   cached_string_width(std::string_view key, std::string_view message);
+    mesh_string::pointer_t  truncate_string(
+                                  detail::code_point_reader & reader
+                                , float max_width
+                                , char32_t ellipsis);
+    glyph_pool::instance_vector_t
+                            convert_instances(detail::code_point_reader & reader);
+
     mesh::map_t             f_map = mesh::map_t();
+    bool                    f_placeholders = false;
+    usage_profile::pointer_t
+                            f_usage_profile = usage_profile::pointer_t();
     std::shared_ptr<detail::font_impl>
                             f_impl = std::shared_ptr<detail::font_impl>();
 };
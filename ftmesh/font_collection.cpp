@@ -0,0 +1,179 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the font_collection class.
+ *
+ * The faces of a collection are opened through the face registry so the
+ * file gets mapped in memory only once. The fonts created by a
+ * collection also share one outline cache: a glyph found in several
+ * faces (i.e. the Latin and CJK glyphs common to the Japanese, Korean
+ * and Chinese faces of a CJK collection) gets tessellated only once
+ * per set of settings.
+ */
+
+// self
+//
+#include    "ftmesh/font_collection.h"
+
+#include    "ftmesh/face_registry.h"
+#include    "ftmesh/outline_cache.h"
+
+
+// C++
+//
+#include    <stdexcept>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+/** \brief Open a font collection.
+ *
+ * The constructor opens the first face to read the number of faces
+ * included in the file. Regular font files are viewed as collections
+ * of one face.
+ *
+ * \exception std::runtime_error
+ * The file could not be opened or is not a supported font.
+ *
+ * \param[in] filename  The name of the font file.
+ */
+font_collection::font_collection(std::string const & filename)
+    : f_filename(filename)
+    , f_outline_cache(std::make_shared<detail::outline_cache>())
+{
+    detail::face_registry::face::pointer_t face(
+            detail::face_registry::get_instance()->get_face(f_filename, DEFAULT_FACE_INDEX));
+    f_face_count = static_cast<int>(face->get_face()->num_faces);
+}
+
+
+std::string const & font_collection::get_filename() const
+{
+    return f_filename;
+}
+
+
+/** \brief Get the number of faces in this collection.
+ *
+ * \return The number of faces, 1 for a regular font file.
+ */
+int font_collection::get_face_count() const
+{
+    return f_face_count;
+}
+
+
+/** \brief Get the name of a face.
+ *
+ * The name is the family name followed by the style name, as in
+ * "Noto Sans CJK JP Regular". It can be used to select the face to
+ * pass to get_font().
+ *
+ * \exception std::out_of_range
+ * The \p face_index is not valid for this collection.
+ *
+ * \param[in] face_index  The index of the face.
+ *
+ * \return The name of the face.
+ */
+std::string font_collection::get_face_name(int face_index) const
+{
+    verify_face_index(face_index);
+
+    detail::face_registry::face::pointer_t face(
+            detail::face_registry::get_instance()->get_face(f_filename, face_index));
+    FT_Face const f(face->get_face());
+
+    std::string result(f->family_name == nullptr ? "" : f->family_name);
+    if(f->style_name != nullptr)
+    {
+        if(!result.empty())
+        {
+            result += ' ';
+        }
+        result += f->style_name;
+    }
+    return result;
+}
+
+
+/** \brief Get the number of meshes shared by the fonts of this collection.
+ *
+ * \return The number of distinct outlines tessellated so far and still
+ * used by one of the fonts.
+ */
+std::size_t font_collection::get_outline_count() const
+{
+    return f_outline_cache->size();
+}
+
+
+/** \brief Create a font for one face of the collection.
+ *
+ * Each call returns a new font with its own settings. The meshes are
+ * shared with the other fonts created by this collection whenever the
+ * glyph outlines and the settings are the same.
+ *
+ * \exception std::out_of_range
+ * The \p face_index is not valid for this collection.
+ *
+ * \param[in] face_index  The index of the face.
+ * \param[in] mode  When to open the face (see font::font()).
+ *
+ * \return The new font.
+ */
+font::pointer_t font_collection::get_font(int face_index, open_mode_t mode)
+{
+    verify_face_index(face_index);
+
+    font::pointer_t result(std::make_shared<font>(f_filename, face_index, mode));
+    result->set_outline_cache(f_outline_cache);
+    return result;
+}
+
+
+void font_collection::verify_face_index(int face_index) const
+{
+    if(face_index < 0
+    || face_index >= f_face_count)
+    {
+        throw std::out_of_range(
+                  "face index "
+                + std::to_string(face_index)
+                + " is out of range for \""
+                + f_filename
+                + "\" which has "
+                + std::to_string(f_face_count)
+                + " face(s)");
+    }
+}
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,66 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the font_collection class.
+ *
+ * A font collection (.ttc or .otc file) includes several faces which
+ * often share most of their glyphs. The font_collection class creates
+ * fonts for any of its faces and lets them share their meshes.
+ */
+
+// self
+//
+#include    <ftmesh/font.h>
+
+
+
+namespace ftmesh
+{
+
+
+class font_collection
+{
+public:
+    typedef std::shared_ptr<font_collection>    pointer_t;
+
+                            font_collection(std::string const & filename);
+
+    std::string const &     get_filename() const;
+    int                     get_face_count() const;
+    std::string             get_face_name(int face_index) const;
+    std::size_t             get_outline_count() const;
+
+    font::pointer_t         get_font(
+                                  int face_index
+                                , open_mode_t mode = open_mode_t::OPEN_MODE_IMMEDIATE);
+
+private:
+    void                    verify_face_index(int face_index) const;
+
+    std::string const       f_filename = std::string();
+    int                     f_face_count = 0;
+    std::shared_ptr<detail::outline_cache>
+                            f_outline_cache = std::shared_ptr<detail::outline_cache>();
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
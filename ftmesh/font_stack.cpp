@@ -0,0 +1,327 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the font_stack class.
+ *
+ * No one font covers all the scripts so text mixing scripts needs a
+ * list of fallback fonts. Trying to load each character from each
+ * font until one works would be slow, so the font stack instead builds
+ * a coverage table from the charmap of each font when it gets added.
+ *
+ * The table is indexed in two levels: the code point divided by 256
+ * selects a page and the low 8 bits select the entry in that page. The
+ * entry is the index of the first font including that character. Pages
+ * without any character all share the empty page 0 so the table only
+ * uses memory for the blocks actually covered by the fonts.
+ */
+
+// self
+//
+#include    "ftmesh/font_stack.h"
+
+#include    "ftmesh/code_point_reader.h"
+
+
+// snapdev
+//
+#include    <snapdev/not_used.h>
+
+
+// C++
+//
+#include    <stdexcept>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+namespace
+{
+
+
+constexpr std::uint8_t const    NO_FONT = 255;
+constexpr std::size_t const     MAX_FONTS = NO_FONT;
+constexpr char32_t const        MAX_CODE_POINT = 0x10FFFF;
+constexpr std::size_t const     PAGE_COUNT = (MAX_CODE_POINT >> 8) + 1;
+
+
+} // no name namespace
+
+
+
+/** \brief Create an empty font stack.
+ *
+ * Use add_font() to add fonts, the preferred font first.
+ */
+font_stack::font_stack()
+    : f_page_index(PAGE_COUNT, 0)
+    , f_pages(1)
+{
+    f_pages[0].fill(NO_FONT);
+}
+
+
+/** \brief Add a fallback font.
+ *
+ * The characters of \p f not already covered by the fonts added
+ * earlier get assigned to \p f. This reads the charmap of the font so
+ * a lazy font (see open_mode_t) gets opened.
+ *
+ * \exception std::out_of_range
+ * The stack already includes the maximum number of fonts (255).
+ *
+ * \param[in] f  The font to add.
+ */
+void font_stack::add_font(font::pointer_t f)
+{
+    if(f_fonts.size() >= MAX_FONTS)
+    {
+        throw std::out_of_range("a font stack can include at most 255 fonts");
+    }
+
+    std::uint8_t const index(static_cast<std::uint8_t>(f_fonts.size()));
+    for(char32_t const c : f->get_characters())
+    {
+        if(c > MAX_CODE_POINT)
+        {
+            continue;       // LCOV_EXCL_LINE
+        }
+        std::uint16_t & page(f_page_index[c >> 8]);
+        if(page == 0)
+        {
+            page = static_cast<std::uint16_t>(f_pages.size());
+            f_pages.push_back(f_pages[0]);
+        }
+        std::uint8_t & entry(f_pages[page][c & 0xFF]);
+        if(entry == NO_FONT)
+        {
+            entry = index;
+        }
+    }
+
+    f_fonts.push_back(f);
+}
+
+
+std::size_t font_stack::size() const
+{
+    return f_fonts.size();
+}
+
+
+/** \brief Get one of the fonts of the stack.
+ *
+ * \exception std::out_of_range
+ * The \p index is not smaller than size().
+ *
+ * \param[in] index  The index of the font, 0 for the first font added.
+ *
+ * \return The font at \p index.
+ */
+font::pointer_t font_stack::get_font(std::size_t index) const
+{
+    return f_fonts.at(index);
+}
+
+
+/** \brief Find the font used to render a character.
+ *
+ * \param[in] c  The character to search.
+ *
+ * \return The first font including \p c or nullptr if none does.
+ */
+font::pointer_t font_stack::find_font(char32_t c) const
+{
+    std::size_t const index(find_index(c));
+    if(index == NO_FONT)
+    {
+        return font::pointer_t();
+    }
+    return f_fonts[index];
+}
+
+
+std::size_t font_stack::find_index(char32_t c) const
+{
+    if(c > MAX_CODE_POINT)
+    {
+        return NO_FONT;
+    }
+    return f_pages[f_page_index[c >> 8]][c & 0xFF];
+}
+
+
+/** \brief Get the mesh of a character.
+ *
+ * The mesh comes from the first font including \p c. If none of the
+ * fonts include it, the "missing glyph" of the first font is returned,
+ * as font::get_mesh() would.
+ *
+ * \param[in] c  The character to retrieve.
+ *
+ * \return The mesh or nullptr if the stack is empty or the glyph can't
+ * be loaded.
+ */
+mesh::pointer_t font_stack::get_mesh(char32_t c)
+{
+    if(f_fonts.empty())
+    {
+        return mesh::pointer_t();
+    }
+
+    std::size_t index(find_index(c));
+    if(index == NO_FONT)
+    {
+        index = 0;
+    }
+    return f_fonts[index]->get_mesh(c);
+}
+
+
+/** \brief Call \p callback for each glyph read by \p reader.
+ *
+ * This works like font::for_each_glyph() except that each character
+ * gets its mesh from its own font. The kerning is only applied between
+ * two characters rendered with the same font.
+ *
+ * \param[in] reader  The object returning the code points one by one.
+ * \param[in] callback  The function called with each mesh, advance and
+ * code point.
+ */
+template<typename F>
+void font_stack::for_each_glyph(detail::code_point_reader & reader, F callback)
+{
+    char32_t current(U'\0');
+    if(f_fonts.empty()
+    || !reader.next(current))
+    {
+        return;
+    }
+
+    auto font_index = [this](char32_t c)
+    {
+        std::size_t const index(find_index(c));
+        return index == NO_FONT ? 0 : index;
+    };
+
+    std::size_t current_index(font_index(current));
+    bool more(true);
+    do
+    {
+        char32_t following(U'\0');
+        more = reader.next(following);
+        std::size_t const following_index(more ? font_index(following) : 0);
+
+        font::pointer_t const & f(f_fonts[current_index]);
+        mesh::pointer_t m(f->get_mesh(current));
+        if(m != nullptr)
+        {
+            float advance(m->get_advance());
+            if(more
+            && following_index == current_index)
+            {
+                advance += f->get_kerning(current, following);
+            }
+            callback(m, advance, current);
+        }
+
+        current = following;
+        current_index = following_index;
+    }
+    while(more);
+}
+
+
+/** \brief Convert a string using the fonts of the stack.
+ *
+ * \param[in] message  The string to convert.
+ *
+ * \return The meshes and advances of the characters of \p message.
+ */
+mesh_string::pointer_t font_stack::convert_string(std::string_view message)
+{
+    detail::code_point_reader reader(message);
+    return convert_string(reader);
+}
+
+
+mesh_string::pointer_t font_stack::convert_string(std::u32string_view message)
+{
+    detail::code_point_reader reader(message);
+    return convert_string(reader);
+}
+
+
+mesh_string::pointer_t font_stack::convert_string(detail::code_point_reader & reader)
+{
+    mesh_string::pointer_t result(std::make_shared<mesh_string>());
+
+    for_each_glyph(reader, [&result](mesh::pointer_t const & m, float advance, char32_t code_point)
+        {
+            result->add_glyph(m, advance, code_point);
+        });
+
+    return result;
+}
+
+
+/** \brief Compute the width of a string using the fonts of the stack.
+ *
+ * \param[in] message  The string to measure.
+ *
+ * \return The sum of the advances of the characters of \p message.
+ */
+float font_stack::string_width(std::string_view message)
+{
+    detail::code_point_reader reader(message);
+    return string_width(reader);
+}
+
+
+float font_stack::string_width(std::u32string_view message)
+{
+    detail::code_point_reader reader(message);
+    return string_width(reader);
+}
+
+
+float font_stack::string_width(detail::code_point_reader & reader)
+{
+    float result(0.0f);
+
+    for_each_glyph(reader, [&result](mesh::pointer_t const & m, float advance, char32_t code_point)
+        {
+            snapdev::NOT_USED(m, code_point);
+            result += advance;
+        });
+
+    return result;
+}
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
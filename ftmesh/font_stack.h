@@ -0,0 +1,81 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the font_stack class.
+ *
+ * A font stack is a list of fonts where each character gets rendered
+ * with the first font which includes it.
+ */
+
+// self
+//
+#include    <ftmesh/font.h>
+
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <vector>
+
+
+
+namespace ftmesh
+{
+
+
+class font_stack
+{
+public:
+    typedef std::shared_ptr<font_stack>     pointer_t;
+
+                            font_stack();
+
+    void                    add_font(font::pointer_t f);
+    std::size_t             size() const;
+    font::pointer_t         get_font(std::size_t index) const;
+    font::pointer_t         find_font(char32_t c) const;
+
+    mesh::pointer_t         get_mesh(char32_t c);
+    mesh_string::pointer_t  convert_string(std::string_view message);
+    mesh_string::pointer_t  convert_string(std::u32string_view message);
+    float                   string_width(std::string_view message);
+    float                   string_width(std::u32string_view message);
+
+private:
+    typedef std::array<std::uint8_t, 256>   page_t;
+
+    std::size_t             find_index(char32_t c) const;
+    template<typename F>
+    void                    for_each_glyph(detail::code_point_reader & reader, F callback);
+    mesh_string::pointer_t  convert_string(detail::code_point_reader & reader);
+    float                   string_width(detail::code_point_reader & reader);
+
+    std::vector<font::pointer_t>
+                            f_fonts = std::vector<font::pointer_t>();
+    std::vector<std::uint16_t>
+                            f_page_index = std::vector<std::uint16_t>();
+    std::vector<page_t>     f_pages = std::vector<page_t>();
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,247 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the glyph_pool class.
+ *
+ * The pool is append only: once a glyph was added, its range never
+ * changes. This means a renderer only has to upload the tail of the
+ * vertex and element buffers when new glyphs get added.
+ */
+
+// self
+//
+#include    "ftmesh/glyph_pool.h"
+
+
+// C++
+//
+#include    <utility>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+
+namespace
+{
+
+
+/** \brief Get the triangles of a mesh as a list of elements.
+ *
+ * Each group of three elements is one triangle, whatever the format of
+ * \p m. The strips are unrolled keeping the winding of their triangles
+ * and the degenerate triangles are dropped.
+ *
+ * \param[in] m  The mesh to convert.
+ *
+ * \return The elements of the triangles.
+ */
+glyph_pool::element_vector_t get_triangles(mesh const & m)
+{
+    glyph_pool::element_vector_t result;
+    switch(m.get_format())
+    {
+    case mesh_format_t::MESH_FORMAT_TRIANGLES:
+        result.resize(m.get_points().size());
+        for(std::uint32_t idx(0); idx < result.size(); ++idx)
+        {
+            result[idx] = idx;
+        }
+        break;
+
+    case mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES:
+        result.assign(m.get_elements().begin(), m.get_elements().end());
+        break;
+
+    case mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS:
+        {
+            mesh::element_vector_t const & elements(m.get_elements());
+            std::size_t start(0);
+            for(std::size_t idx(0); idx < elements.size(); ++idx)
+            {
+                if(elements[idx] == PRIMITIVE_RESTART_INDEX)
+                {
+                    start = idx + 1;
+                    continue;
+                }
+                if(idx - start < 2)
+                {
+                    continue;
+                }
+                std::uint32_t a(elements[idx - 2]);
+                std::uint32_t b(elements[idx - 1]);
+                std::uint32_t const c(elements[idx]);
+                if(a == b || b == c || a == c)
+                {
+                    continue;
+                }
+                if(((idx - start) & 1) != 0)
+                {
+                    std::swap(a, b);
+                }
+                result.push_back(a);
+                result.push_back(b);
+                result.push_back(c);
+            }
+        }
+        break;
+
+    }
+
+    return result;
+}
+
+
+} // no name namespace
+
+
+
+glyph_pool::glyph_pool(mesh_format_t format)
+    : f_format(format)
+{
+}
+
+
+/** \brief Add a mesh to the pool.
+ *
+ * If the mesh was already added, the function returns its existing
+ * range identifier. Otherwise its vertices are appended to the vertex
+ * buffer as (x, y) float pairs and its elements are appended to the
+ * element buffer. The elements are relative to the first vertex of the
+ * range (i.e. use f_first_vertex as the base vertex when drawing).
+ *
+ * The elements are converted to the format of the pool when the mesh
+ * uses another format (i.e. it was cached before the format of the
+ * font changed). In a MESH_FORMAT_TRIANGLE_STRIPS pool, such triangles
+ * become strips of one triangle separated by PRIMITIVE_RESTART_INDEX.
+ * Composite meshes are flattened.
+ *
+ * The pool does not keep the meshes alive. The geometry of a mesh
+ * remains in the buffers after the mesh is released.
+ *
+ * \param[in] m  The mesh to add to the pool.
+ *
+ * \return The identifier of the range of this mesh.
+ */
+glyph_pool::range_id_t glyph_pool::add_mesh(mesh::pointer_t m)
+{
+    auto it(f_ids.find(m));
+    if(it != f_ids.end())
+    {
+        return it->second;
+    }
+
+    mesh::pointer_t const source(m->is_composite() ? m->flatten() : m);
+
+    range r;
+    r.f_first_vertex = static_cast<std::uint32_t>(f_vertices.size() / 2);
+    r.f_first_element = static_cast<std::uint32_t>(f_elements.size());
+
+    mesh::point_vector_t const & points(source->get_points());
+    r.f_vertex_count = static_cast<std::uint32_t>(points.size());
+    f_vertices.reserve(f_vertices.size() + points.size() * 2);
+    for(auto const & p : points)
+    {
+        f_vertices.push_back(static_cast<float>(p.x()));
+        f_vertices.push_back(static_cast<float>(p.y()));
+    }
+
+    if(source->get_format() == mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS
+    && f_format == mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS)
+    {
+        mesh::element_vector_t const & elements(source->get_elements());
+        f_elements.insert(f_elements.end(), elements.begin(), elements.end());
+    }
+    else
+    {
+        element_vector_t const triangles(get_triangles(*source));
+        if(f_format == mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS)
+        {
+            for(std::size_t idx(0); idx + 2 < triangles.size(); idx += 3)
+            {
+                if(idx != 0)
+                {
+                    f_elements.push_back(PRIMITIVE_RESTART_INDEX);
+                }
+                f_elements.insert(f_elements.end(), triangles.begin() + idx, triangles.begin() + idx + 3);
+            }
+        }
+        else
+        {
+            f_elements.insert(f_elements.end(), triangles.begin(), triangles.end());
+        }
+    }
+    r.f_element_count = static_cast<std::uint32_t>(f_elements.size()) - r.f_first_element;
+
+    range_id_t const id(static_cast<range_id_t>(f_ranges.size()));
+    f_ranges.push_back(r);
+    f_ids[m] = id;
+
+    return id;
+}
+
+
+mesh_format_t glyph_pool::get_format() const
+{
+    return f_format;
+}
+
+
+/** \brief Get the vertex buffer.
+ *
+ * The vertices are saved as (x, y) pairs of floats. The buffer only
+ * grows so the ranges returned earlier remain valid.
+ *
+ * \return The vertices of all the glyphs in the pool.
+ */
+glyph_pool::vertex_vector_t const & glyph_pool::get_vertices() const
+{
+    return f_vertices;
+}
+
+
+glyph_pool::element_vector_t const & glyph_pool::get_elements() const
+{
+    return f_elements;
+}
+
+
+glyph_pool::range_vector_t const & glyph_pool::get_ranges() const
+{
+    return f_ranges;
+}
+
+
+glyph_pool::range const & glyph_pool::get_range(range_id_t id) const
+{
+    return f_ranges.at(id);
+}
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,98 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the glyph_pool class.
+ *
+ * The glyph pool packs the meshes of many glyphs in a single vertex
+ * buffer and a single element buffer. Each glyph is given a range in
+ * those buffers. A string can then be rendered with one instanced or
+ * multi-draw-indirect call using a stream of instances, each one being
+ * a range identifier and a position.
+ */
+
+// self
+//
+#include    <ftmesh/mesh.h>
+
+
+// C++
+//
+#include    <memory>
+
+
+namespace ftmesh
+{
+
+
+class glyph_pool
+{
+public:
+    typedef std::shared_ptr<glyph_pool>     pointer_t;
+    typedef std::uint32_t                   range_id_t;
+    typedef std::vector<float>              vertex_vector_t;
+    typedef std::vector<std::uint32_t>      element_vector_t;
+
+    // this is NOT the layout of a DrawElementsIndirectCommand, which is
+    // {count, instanceCount, firstIndex, baseVertex, baseInstance}; to
+    // build such a command use f_element_count as count, f_first_element
+    // as firstIndex and f_first_vertex as baseVertex
+    //
+    struct range
+    {
+        std::uint32_t           f_element_count = 0;
+        std::uint32_t           f_first_element = 0;
+        std::uint32_t           f_first_vertex = 0;
+        std::uint32_t           f_vertex_count = 0;
+    };
+    typedef std::vector<range>              range_vector_t;
+
+    struct instance
+    {
+        range_id_t              f_range = 0;
+        float                   f_x = 0.0f;
+        float                   f_y = 0.0f;
+    };
+    typedef std::vector<instance>           instance_vector_t;
+
+                                glyph_pool(mesh_format_t format = mesh_format_t::MESH_FORMAT_TRIANGLES);
+
+    range_id_t                  add_mesh(mesh::pointer_t m);
+
+    mesh_format_t               get_format() const;
+    vertex_vector_t const &     get_vertices() const;
+    element_vector_t const &    get_elements() const;
+    range_vector_t const &      get_ranges() const;
+    range const &               get_range(range_id_t id) const;
+
+private:
+    typedef std::map<std::weak_ptr<mesh>, range_id_t, std::owner_less<std::weak_ptr<mesh>>>
+                                id_map_t;
+
+    id_map_t                    f_ids = id_map_t();
+    mesh_format_t               f_format = mesh_format_t::MESH_FORMAT_TRIANGLES;
+    vertex_vector_t             f_vertices = vertex_vector_t();
+    element_vector_t            f_elements = element_vector_t();
+    range_vector_t              f_ranges = range_vector_t();
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,411 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+
+/** \file
+ * \brief Implementation of the layout class.
+ *
+ * The layout class breaks a paragraph in lines. Calling string_width()
+ * on longer and longer prefixes of the text to find where to break is
+ * quadratic. Instead, the layout computes the advance of each character
+ * (kerning included) once and keeps the prefix sums of those advances.
+ * The width of any run of characters is then the difference between
+ * two sums and the line breaks are found in a single pass.
+ */
+
+// self
+//
+#include    "ftmesh/layout.h"
+
+#include    "ftmesh/code_point_reader.h"
+
+
+// C++
+//
+#include    <stdexcept>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+namespace
+{
+
+
+bool is_space(char32_t c)
+{
+    return c == U' ' || c == U'\t';
+}
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a layout object.
+ *
+ * The layout uses \p f to get the meshes, advances and kerning of
+ * the characters. The font must remain valid as long as the layout is
+ * used to convert text.
+ *
+ * By default, the maximum width is 0 meaning that lines only get broken
+ * on newline characters. The line height defaults to the one defined
+ * by the font (see font::get_line_height()).
+ *
+ * \param[in] f  The font used to lay out text.
+ */
+layout::layout(font & f)
+    : f_font(f)
+{
+}
+
+
+/** \brief Set the maximum width of a line.
+ *
+ * Lines are broken at the last space which lets the line fit within
+ * this width. A word longer than the maximum width is broken between
+ * two characters.
+ *
+ * A width of 0 means that there is no limit.
+ *
+ * \exception std::runtime_error
+ * The width cannot be negative.
+ *
+ * \param[in] max_width  The new maximum width.
+ */
+void layout::set_max_width(float max_width)
+{
+    if(max_width < 0.0f)
+    {
+        throw std::runtime_error("the maximum width of a layout cannot be negative.");
+    }
+    f_max_width = max_width;
+}
+
+
+/** \brief Set the distance between two baselines.
+ *
+ * Use 0 (the default) to use the line height defined by the font.
+ *
+ * \exception std::runtime_error
+ * The line height cannot be negative.
+ *
+ * \param[in] line_height  The new line height.
+ */
+void layout::set_line_height(float line_height)
+{
+    if(line_height < 0.0f)
+    {
+        throw std::runtime_error("the line height of a layout cannot be negative.");
+    }
+    f_line_height = line_height;
+}
+
+
+void layout::set_alignment(align_t alignment)
+{
+    f_alignment = alignment;
+}
+
+
+/** \brief Break \p text in lines and position its glyphs.
+ *
+ * See the UTF-32 version of this function for details. The characters
+ * get decoded while being measured so no UTF-32 copy of the paragraph
+ * is created.
+ *
+ * \exception libutf8::libutf8_exception_decoding
+ * The \p text is not valid UTF-8.
+ *
+ * \param[in] text  The UTF-8 paragraph to lay out.
+ */
+void layout::convert(std::string_view text)
+{
+    detail::code_point_reader reader(text);
+    convert(reader);
+}
+
+
+/** \brief Break \p text in lines and position its glyphs.
+ *
+ * The first pass computes the advance of each character, kerning with
+ * the following character included, and its prefix sum. While doing so,
+ * it remembers the last space found on the current line. As soon as a
+ * character goes past the maximum width, the line ends at that space
+ * (or before that character if the line has no space). Since the prefix
+ * sums are already known, the characters following the space do not
+ * need to be measured again. A newline character always ends the line.
+ *
+ * The spaces at the place where a line gets broken are not included in
+ * the output and do not count in the width of the line.
+ *
+ * The second pass positions the glyphs of each line according to the
+ * alignment. The first baseline is at y = 0 and the following lines go
+ * down (negative y) by the line height.
+ *
+ * \param[in] text  The paragraph to lay out.
+ */
+void layout::convert(std::u32string_view text)
+{
+    detail::code_point_reader reader(text);
+    convert(reader);
+}
+
+
+void layout::convert(detail::code_point_reader & reader)
+{
+    f_glyphs.clear();
+    f_lines.clear();
+    f_width = 0.0f;
+
+    // the kerning of a character is only known once the next one is
+    // read; the entry after the last character only holds the total
+    // advance (prefix sum)
+    //
+    struct character
+    {
+        char32_t            f_code_point = U'\0';
+        mesh::pointer_t     f_mesh = mesh::pointer_t();
+        float               f_kerning = 0.0f;
+        float               f_offset = 0.0f;
+    };
+    std::vector<character> characters;
+    characters.reserve(reader.size_hint() + 1);
+    char32_t c(U'\0');
+    while(reader.next(c))
+    {
+        if(!characters.empty())
+        {
+            character & previous(characters.back());
+            if(previous.f_mesh != nullptr
+            && c != U'\n')
+            {
+                previous.f_kerning = f_font.get_kerning(previous.f_code_point, c);
+            }
+        }
+
+        character current;
+        current.f_code_point = c;
+        if(c != U'\n')
+        {
+            current.f_mesh = f_font.get_mesh(c);
+        }
+        characters.push_back(current);
+    }
+    std::size_t const size(characters.size());
+    characters.emplace_back();
+    for(std::size_t idx(0); idx < size; ++idx)
+    {
+        float advance(characters[idx].f_kerning);
+        if(characters[idx].f_mesh != nullptr)
+        {
+            advance += characters[idx].f_mesh->get_advance();
+        }
+        characters[idx + 1].f_offset = characters[idx].f_offset + advance;
+    }
+    auto text = [&characters](std::size_t idx)
+    {
+        return characters[idx].f_code_point;
+    };
+
+    struct range
+    {
+        std::size_t     f_start = 0;
+        std::size_t     f_end = 0;
+    };
+    std::vector<range> ranges;
+
+    // width of [start, end) without the kerning with the character after
+    //
+    auto width = [&](std::size_t start, std::size_t end)
+    {
+        return start == end
+                ? 0.0f
+                : characters[end].f_offset - characters[start].f_offset - characters[end - 1].f_kerning;
+    };
+
+    std::size_t start(0);
+    std::size_t break_at(0);
+    bool has_break(false);
+    for(std::size_t idx(0); idx < size;)
+    {
+        c = text(idx);
+        if(c == U'\n')
+        {
+            ranges.push_back({ start, idx });
+            start = idx + 1;
+            has_break = false;
+            ++idx;
+            continue;
+        }
+        if(is_space(c))
+        {
+            if(idx > start)
+            {
+                break_at = idx;
+                has_break = true;
+            }
+            ++idx;
+            continue;
+        }
+        if(f_max_width <= 0.0f
+        || idx == start
+        || width(start, idx + 1) <= f_max_width)
+        {
+            ++idx;
+            continue;
+        }
+
+        // this character does not fit, end the line
+        //
+        std::size_t end(idx);
+        std::size_t next(idx);
+        if(has_break)
+        {
+            end = break_at;
+            next = break_at;
+        }
+        while(end > start
+           && is_space(text(end - 1)))
+        {
+            --end;
+        }
+        while(next < size
+           && is_space(text(next)))
+        {
+            ++next;
+        }
+        ranges.push_back({ start, end });
+        start = next;
+        has_break = false;
+
+        // the characters between the break and here are already
+        // measured, we only need to find the last space among them;
+        // then the current character is checked again against the
+        // new line
+        //
+        for(std::size_t j(start); j < idx; ++j)
+        {
+            if(is_space(text(j))
+            && j > start)
+            {
+                break_at = j;
+                has_break = true;
+            }
+        }
+    }
+    ranges.push_back({ start, size });
+
+    float const line_height(f_line_height > 0.0f
+                                ? f_line_height
+                                : f_font.get_line_height());
+    for(auto const & r : ranges)
+    {
+        float const w(width(r.f_start, r.f_end));
+        if(w > f_width)
+        {
+            f_width = w;
+        }
+    }
+    float const box_width(f_max_width > 0.0f ? f_max_width : f_width);
+
+    float y(0.0f);
+    for(auto const & r : ranges)
+    {
+        line l;
+        l.f_first_glyph = f_glyphs.size();
+        l.f_width = width(r.f_start, r.f_end);
+        l.f_y = y;
+        switch(f_alignment)
+        {
+        case align_t::ALIGN_LEFT:
+            break;
+
+        case align_t::ALIGN_CENTER:
+            l.f_x = (box_width - l.f_width) / 2.0f;
+            break;
+
+        case align_t::ALIGN_RIGHT:
+            l.f_x = box_width - l.f_width;
+            break;
+
+        }
+        for(std::size_t idx(r.f_start); idx < r.f_end; ++idx)
+        {
+            if(characters[idx].f_mesh != nullptr)
+            {
+                positioned_glyph g;
+                g.f_mesh = characters[idx].f_mesh;
+                g.f_code_point = characters[idx].f_code_point;
+                g.f_x = l.f_x + characters[idx].f_offset - characters[r.f_start].f_offset;
+                g.f_y = y;
+                f_glyphs.push_back(g);
+            }
+        }
+        l.f_glyph_count = f_glyphs.size() - l.f_first_glyph;
+        f_lines.push_back(l);
+        y -= line_height;
+    }
+}
+
+
+positioned_glyph::vector_t const & layout::get_glyphs() const
+{
+    return f_glyphs;
+}
+
+
+layout::line_vector_t const & layout::get_lines() const
+{
+    return f_lines;
+}
+
+
+/** \brief Get the width of the widest line.
+ *
+ * \return The width of the widest line of the last convert() call.
+ */
+float layout::get_width() const
+{
+    return f_width;
+}
+
+
+/** \brief Get the height of the paragraph.
+ *
+ * This is the number of lines times the line height.
+ *
+ * \return The height of the paragraph of the last convert() call.
+ */
+float layout::get_height() const
+{
+    float const line_height(f_line_height > 0.0f
+                                ? f_line_height
+                                : f_font.get_line_height());
+    return static_cast<float>(f_lines.size()) * line_height;
+}
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,90 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+#pragma once
+
+/** \file
+ * \brief Definitions of the layout class.
+ *
+ * The layout class breaks a paragraph in lines which fit a maximum
+ * width and positions each glyph on its line.
+ */
+
+// self
+//
+#include    <ftmesh/font.h>
+
+
+
+namespace ftmesh
+{
+
+
+enum class align_t
+{
+    ALIGN_LEFT,
+    ALIGN_CENTER,
+    ALIGN_RIGHT,
+};
+
+
+class layout
+{
+public:
+    typedef std::shared_ptr<layout>     pointer_t;
+
+    struct line
+    {
+        std::size_t         f_first_glyph = 0;
+        std::size_t         f_glyph_count = 0;
+        float               f_x = 0.0f;
+        float               f_y = 0.0f;
+        float               f_width = 0.0f;
+    };
+    typedef std::vector<line>           line_vector_t;
+
+                            layout(font & f);
+
+    void                    set_max_width(float max_width);
+    void                    set_line_height(float line_height);
+    void                    set_alignment(align_t alignment);
+
+    void                    convert(std::string_view text);
+    void                    convert(std::u32string_view text);
+
+    positioned_glyph::vector_t const &
+                            get_glyphs() const;
+    line_vector_t const &   get_lines() const;
+    float                   get_width() const;
+    float                   get_height() const;
+
+private:
+    void                    convert(detail::code_point_reader & reader);
+
+    font &                  f_font;
+    float                   f_max_width = 0.0f;
+    float                   f_line_height = 0.0f;
+    align_t                 f_alignment = align_t::ALIGN_LEFT;
+    positioned_glyph::vector_t
+                            f_glyphs = positioned_glyph::vector_t();
+    line_vector_t           f_lines = line_vector_t();
+    float                   f_width = 0.0f;
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -34,6 +34,12 @@
 #include    <GL/gl.h>
 
 
+// C++
+//
+#include    <stdexcept>
+#include    <unordered_map>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -51,9 +57,282 @@ namespace ftmesh
 {
 
 
+namespace
+{
+
+
+typedef std::vector<std::vector<std::uint32_t>>     adjacency_t;
+
+// the temporary lists do not need the slab allocator of the meshes
+//
+typedef std::vector<std::uint32_t>                  element_list_t;
+
+
+/** \brief Reorder triangles to make good use of the GPU vertex cache.
+ *
+ * This function implements the Tipsify algorithm as described in
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+ * by Sander, Nehab and Barczak (2007). It is linear in the number of
+ * triangles and gives results close to the best known algorithms.
+ *
+ * The algorithm "fans" around one vertex at a time, emitting all the
+ * triangles that use that vertex, then selects the next fanning vertex
+ * among the vertices just emitted that are still in the cache.
+ *
+ * \param[in] elements  The triangle list (3 elements per triangle).
+ * \param[in] vertex_count  The number of vertices referenced by \p elements.
+ * \param[in] cache_size  The expected size of the GPU post-transform cache.
+ *
+ * \return The triangles in the new order.
+ */
+element_list_t tipsify(
+          element_list_t const & elements
+        , std::size_t vertex_count
+        , std::size_t cache_size)
+{
+    std::size_t const triangle_count(elements.size() / 3);
+
+    adjacency_t adjacency(vertex_count);
+    for(std::size_t t(0); t < triangle_count; ++t)
+    {
+        for(std::size_t j(0); j < 3; ++j)
+        {
+            adjacency[elements[t * 3 + j]].push_back(static_cast<std::uint32_t>(t));
+        }
+    }
+
+    std::vector<int> live(vertex_count);
+    for(std::size_t v(0); v < vertex_count; ++v)
+    {
+        live[v] = static_cast<int>(adjacency[v].size());
+    }
+
+    int const k(static_cast<int>(cache_size));
+    std::vector<int> cache_time(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<std::uint32_t> dead_end;
+    std::vector<std::uint32_t> candidates;
+    element_list_t result;
+    result.reserve(elements.size());
+
+    int fanning(vertex_count > 0 ? 0 : -1);
+    int time(k + 1);
+    std::size_t cursor(1);
+    while(fanning >= 0)
+    {
+        candidates.clear();
+        for(auto const t : adjacency[fanning])
+        {
+            if(emitted[t])
+            {
+                continue;
+            }
+            for(std::size_t j(0); j < 3; ++j)
+            {
+                std::uint32_t const v(elements[t * 3 + j]);
+                result.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if(time - cache_time[v] > k)
+                {
+                    cache_time[v] = time;
+                    ++time;
+                }
+            }
+            emitted[t] = true;
+        }
 
-mesh::mesh(float advance)
-    : f_advance(advance)
+        // select the next fanning vertex among the candidates, prefer
+        // vertices still in the cache which will not be evicted while
+        // we fan around them
+        //
+        fanning = -1;
+        int best(-1);
+        for(auto const v : candidates)
+        {
+            if(live[v] > 0)
+            {
+                int priority(0);
+                if(time - cache_time[v] + 2 * live[v] <= k)
+                {
+                    priority = time - cache_time[v];
+                }
+                if(priority > best)
+                {
+                    best = priority;
+                    fanning = static_cast<int>(v);
+                }
+            }
+        }
+
+        // no luck, try the dead-end stack, then a linear search
+        //
+        while(fanning < 0 && !dead_end.empty())
+        {
+            std::uint32_t const v(dead_end.back());
+            dead_end.pop_back();
+            if(live[v] > 0)
+            {
+                fanning = static_cast<int>(v);
+            }
+        }
+        for(; fanning < 0 && cursor < vertex_count; ++cursor)
+        {
+            if(live[cursor] > 0)
+            {
+                fanning = static_cast<int>(cursor);
+            }
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Transform a list of triangles in a list of strips.
+ *
+ * This function greedily walks the triangles in the order they are
+ * defined (which is expected to be the vertex cache optimized order)
+ * and extends each strip with a neighbor triangle that shares the
+ * last edge of the strip with the correct winding.
+ *
+ * Strips are separated by PRIMITIVE_RESTART_INDEX. The winding of
+ * each triangle is preserved.
+ *
+ * \param[in] elements  The triangle list (3 elements per triangle).
+ *
+ * \return The strips with primitive restart indexes.
+ */
+element_list_t build_strips(element_list_t const & elements)
+{
+    std::size_t const triangle_count(elements.size() / 3);
+
+    auto edge_key = [](std::uint32_t u, std::uint32_t v)
+    {
+        return (static_cast<std::uint64_t>(u) << 32) | v;
+    };
+
+    // directed edge -> triangle
+    //
+    std::unordered_map<std::uint64_t, std::uint32_t> edges;
+    for(std::size_t t(0); t < triangle_count; ++t)
+    {
+        std::uint32_t const * tri(elements.data() + t * 3);
+        std::uint32_t const triangle(static_cast<std::uint32_t>(t));
+        edges.emplace(edge_key(tri[0], tri[1]), triangle);
+        edges.emplace(edge_key(tri[1], tri[2]), triangle);
+        edges.emplace(edge_key(tri[2], tri[0]), triangle);
+    }
+
+    std::vector<bool> used(triangle_count, false);
+
+    // search an unused triangle with the directed edge (u, v) and
+    // return its third vertex
+    //
+    auto find_next = [&](std::uint32_t u, std::uint32_t v, bool mark) -> std::int64_t
+    {
+        auto it(edges.find(edge_key(u, v)));
+        if(it == edges.end()
+        || used[it->second])
+        {
+            return -1;
+        }
+        std::uint32_t const * tri(elements.data() + it->second * 3);
+        for(std::size_t j(0); j < 3; ++j)
+        {
+            if(tri[j] != u && tri[j] != v)
+            {
+                if(mark)
+                {
+                    used[it->second] = true;
+                }
+                return tri[j];
+            }
+        }
+        return -1;
+    };
+
+    element_list_t result;
+    result.reserve(elements.size() + triangle_count);
+    element_list_t strip;
+    for(std::size_t t(0); t < triangle_count; ++t)
+    {
+        if(used[t])
+        {
+            continue;
+        }
+        used[t] = true;
+
+        // choose the rotation which lets us continue the strip
+        //
+        std::uint32_t const * tri(elements.data() + t * 3);
+        std::size_t rotation(0);
+        for(std::size_t r(0); r < 3; ++r)
+        {
+            if(find_next(tri[(r + 2) % 3], tri[(r + 1) % 3], false) >= 0)
+            {
+                rotation = r;
+                break;
+            }
+        }
+
+        strip.clear();
+        strip.push_back(tri[rotation]);
+        strip.push_back(tri[(rotation + 1) % 3]);
+        strip.push_back(tri[(rotation + 2) % 3]);
+        for(;;)
+        {
+            std::size_t const k(strip.size() - 2);
+            std::int64_t const next((k & 1) == 0
+                    ? find_next(strip[k], strip[k + 1], true)
+                    : find_next(strip[k + 1], strip[k], true));
+            if(next < 0)
+            {
+                break;
+            }
+            strip.push_back(static_cast<std::uint32_t>(next));
+        }
+
+        if(!result.empty())
+        {
+            result.push_back(PRIMITIVE_RESTART_INDEX);
+        }
+        result.insert(result.end(), strip.begin(), strip.end());
+    }
+
+    return result;
+}
+
+
+} // no name namespace
+
+
+
+point mesh::component::transform(point const & p) const
+{
+    return point(
+              f_matrix[0] * p.x() + f_matrix[1] * p.y() + f_matrix[4]
+            , f_matrix[2] * p.x() + f_matrix[3] * p.y() + f_matrix[5]);
+}
+
+
+
+/** \brief Initialize a mesh.
+ *
+ * When \p storage is defined, the points, indexes and elements of the
+ * mesh get allocated in that slab. The mesh keeps a reference to the
+ * slab so its data remains valid as long as the mesh exists.
+ *
+ * \param[in] advance  The advance of this glyph.
+ * \param[in] storage  The slab where the data gets allocated or nullptr.
+ */
+mesh::mesh(float advance, slab::pointer_t storage)
+    : f_slab(storage)
+    , f_points(storage != nullptr ? storage.get() : std::pmr::get_default_resource())
+    , f_indexes(storage != nullptr ? storage.get() : std::pmr::get_default_resource())
+    , f_elements(storage != nullptr ? storage.get() : std::pmr::get_default_resource())
+    , f_advance(advance)
 {
 }
 
@@ -68,6 +347,7 @@ void mesh::begin()
 void mesh::add_point(point const & point)
 {
     f_points.push_back(point);
+    f_bounds.add_point(point);
 }
 
 
@@ -76,7 +356,251 @@ void mesh::end()
 }
 
 
-point::vector_t const & mesh::get_points() const
+/** \brief Optimize the mesh for rendering with a GPU.
+ *
+ * The GLU tessellator generates triangles in its sweep order and
+ * duplicates each vertex for each triangle using it. This function
+ * transforms the mesh in an indexed mesh: the points become a set of
+ * unique vertices and the elements reference those vertices.
+ *
+ * The triangles get reordered using the Tipsify algorithm so as to
+ * make good use of the GPU post-transform vertex cache. The vertices
+ * are then sorted in the order they first get used.
+ *
+ * When \p format is MESH_FORMAT_TRIANGLE_STRIPS, the triangles are
+ * further transformed in strips separated by PRIMITIVE_RESTART_INDEX
+ * (use glPrimitiveRestartIndex() or GL_PRIMITIVE_RESTART_FIXED_INDEX).
+ *
+ * Once optimized, the get_indexes() function returns an empty vector.
+ *
+ * \exception std::logic_error
+ * The mesh can only be optimized once.
+ *
+ * \param[in] format  The output format, MESH_FORMAT_TRIANGLES is a no-op.
+ * \param[in] cache_size  The size of the vertex cache to optimize for.
+ */
+void mesh::optimize(mesh_format_t format, std::size_t cache_size)
+{
+    if(format == mesh_format_t::MESH_FORMAT_TRIANGLES)
+    {
+        return;
+    }
+    if(f_format != mesh_format_t::MESH_FORMAT_TRIANGLES)
+    {
+        throw std::logic_error("mesh::optimize() can only be called once.");
+    }
+
+    // merge duplicated vertices
+    //
+    auto compare = [](point const & a, point const & b)
+    {
+        return a.x() < b.x() || (!(b.x() < a.x()) && a.y() < b.y());
+    };
+    std::map<point, std::uint32_t, decltype(compare)> unique(compare);
+    point::vector_t vertices;
+    element_list_t elements;
+    elements.reserve(f_points.size());
+    for(auto const & p : f_points)
+    {
+        auto const it(unique.emplace(p, static_cast<std::uint32_t>(vertices.size())));
+        if(it.second)
+        {
+            vertices.push_back(p);
+        }
+        elements.push_back(it.first->second);
+    }
+
+    elements = tipsify(elements, vertices.size(), cache_size);
+
+    if(format == mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS)
+    {
+        elements = build_strips(elements);
+    }
+
+    // renumber the vertices in the order they get used
+    //
+    element_list_t remap(vertices.size(), PRIMITIVE_RESTART_INDEX);
+    f_points.clear();
+    for(auto & e : elements)
+    {
+        if(e == PRIMITIVE_RESTART_INDEX)
+        {
+            continue;
+        }
+        if(remap[e] == PRIMITIVE_RESTART_INDEX)
+        {
+            remap[e] = static_cast<std::uint32_t>(f_points.size());
+            f_points.push_back(vertices[e]);
+        }
+        e = remap[e];
+    }
+
+    f_points.shrink_to_fit();
+    f_indexes.clear();
+    f_elements.assign(elements.begin(), elements.end());
+    f_format = format;
+}
+
+
+/** \brief Set the bearings of the glyph.
+ *
+ * The bearings come from the font metrics. The horizontal bearing is
+ * the distance from the pen position to the left side of the glyph.
+ * The vertical bearing is the distance from the baseline to the top
+ * of the glyph.
+ *
+ * These are given by the font which computes them while building the
+ * mesh. The ink bounding box, computed from the actual vertices, is
+ * available with get_bounds().
+ *
+ * \param[in] x  The horizontal (left side) bearing.
+ * \param[in] y  The vertical (top side) bearing.
+ */
+void mesh::set_bearing(float x, float y)
+{
+    f_bearing_x = x;
+    f_bearing_y = y;
+}
+
+
+/** \brief Add a component to a composite mesh.
+ *
+ * Many fonts define accented letters as a composite of other glyphs
+ * (i.e. an "e" and an acute accent). Instead of tessellating the whole
+ * composite, the font can tessellate each component once and reference
+ * those meshes from the composite with a transformation.
+ *
+ * A composite mesh does not have points of its own. The renderer either
+ * draws each component with its transform or calls flatten() to get a
+ * standalone copy of the composite.
+ *
+ * \exception std::logic_error
+ * All the components must use the same format and a mesh with points
+ * cannot also have components.
+ *
+ * \param[in] c  The component to add.
+ */
+void mesh::add_component(component const & c)
+{
+    if(!f_points.empty())
+    {
+        throw std::logic_error("mesh::add_component() called on a mesh which already has points.");
+    }
+    if(f_components.empty())
+    {
+        f_format = c.f_mesh->get_format();
+    }
+    else if(f_format != c.f_mesh->get_format())
+    {
+        throw std::logic_error("mesh::add_component() called with a component of a different format.");
+    }
+
+    f_components.push_back(c);
+
+    // transform the corners of the component box; with a rotation this
+    // is a conservative box
+    //
+    box const & b(c.f_mesh->get_bounds());
+    if(!b.is_empty())
+    {
+        f_bounds.add_point(c.transform(b.f_min));
+        f_bounds.add_point(c.transform(b.f_max));
+        f_bounds.add_point(c.transform(point(b.f_min.x(), b.f_max.y())));
+        f_bounds.add_point(c.transform(point(b.f_max.x(), b.f_min.y())));
+    }
+}
+
+
+/** \brief Create a standalone copy of a composite mesh.
+ *
+ * This function applies the transformation of each component to its
+ * points and concatenates the results in a new mesh. This is useful
+ * for renderers which do not want to deal with components. No new
+ * tessellation is required.
+ *
+ * If the mesh is not a composite, the function returns a copy.
+ *
+ * \return A new mesh without components.
+ */
+mesh::pointer_t mesh::flatten() const
+{
+    pointer_t result(std::make_shared<mesh>(f_advance));
+    result->f_bearing_x = f_bearing_x;
+    result->f_bearing_y = f_bearing_y;
+    result->f_format = f_format;
+    if(f_components.empty())
+    {
+        result->f_points = f_points;
+        result->f_indexes = f_indexes;
+        result->f_elements = f_elements;
+        result->f_bounds = f_bounds;
+        return result;
+    }
+
+    for(auto const & c : f_components)
+    {
+        pointer_t const m(c.f_mesh->is_composite() ? c.f_mesh->flatten() : c.f_mesh);
+        std::uint32_t const base(static_cast<std::uint32_t>(result->f_points.size()));
+        for(auto const & p : m->f_points)
+        {
+            result->add_point(c.transform(p));
+        }
+        for(auto const i : m->f_indexes)
+        {
+            result->f_indexes.push_back(i + base);
+        }
+        if(!m->f_elements.empty())
+        {
+            if(f_format == mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS
+            && !result->f_elements.empty())
+            {
+                result->f_elements.push_back(PRIMITIVE_RESTART_INDEX);
+            }
+            for(auto const e : m->f_elements)
+            {
+                result->f_elements.push_back(e == PRIMITIVE_RESTART_INDEX ? e : e + base);
+            }
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Copy this mesh to a slab.
+ *
+ * The font builds its meshes with the default allocator since the
+ * tessellation and optimization steps grow and shrink the vectors.
+ * Once done, the final mesh gets copied to the slab where its data
+ * uses exactly the space it needs, right after the previous glyph.
+ *
+ * \param[in] storage  The slab where the copy allocates its data.
+ *
+ * \return The new mesh.
+ */
+mesh::pointer_t mesh::copy(slab::pointer_t storage) const
+{
+    pointer_t result(std::make_shared<mesh>(f_advance, storage));
+    result->f_points.assign(f_points.begin(), f_points.end());
+    result->f_elements.assign(f_elements.begin(), f_elements.end());
+    result->f_indexes.assign(f_indexes.begin(), f_indexes.end());
+    result->f_format = f_format;
+    result->f_bearing_x = f_bearing_x;
+    result->f_bearing_y = f_bearing_y;
+    result->f_bounds = f_bounds;
+    result->f_components = f_components;
+    result->f_placeholder = f_placeholder;
+    return result;
+}
+
+
+mesh_format_t mesh::get_format() const
+{
+    return f_format;
+}
+
+
+mesh::point_vector_t const & mesh::get_points() const
 {
     return f_points;
 }
@@ -88,6 +612,12 @@ mesh::index_vector_t const & mesh::get_indexes() const
 }
 
 
+mesh::element_vector_t const & mesh::get_elements() const
+{
+    return f_elements;
+}
+
+
 //mesh::type_vector_t const & mesh::get_types() const
 //{
 //    return f_types;
@@ -100,5 +630,106 @@ float mesh::get_advance() const
 }
 
 
+float mesh::get_bearing_x() const
+{
+    return f_bearing_x;
+}
+
+
+float mesh::get_bearing_y() const
+{
+    return f_bearing_y;
+}
+
+
+/** \brief Get the ink bounding box of the glyph.
+ *
+ * The box is computed as the points get added to the mesh so it is
+ * readily available. It is empty for glyphs without an outline such
+ * as the space character.
+ *
+ * \return The bounding box of the mesh vertices.
+ */
+box const & mesh::get_bounds() const
+{
+    return f_bounds;
+}
+
+
+bool mesh::is_composite() const
+{
+    return !f_components.empty();
+}
+
+
+/** \brief Restore the data of a mesh saved in raw arrays.
+ *
+ * This function is used to rebuild a mesh saved outside of this object
+ * (i.e. in a shared memory cache) without going through the tessellator
+ * and optimize() again. The mesh is expected to be empty.
+ *
+ * \exception std::logic_error
+ * The mesh already has points.
+ *
+ * \param[in] format  The format of the saved mesh.
+ * \param[in] xy  The coordinates of the points, two doubles per point.
+ * \param[in] point_count  The number of points.
+ * \param[in] indexes  The start of each primitive (see begin()).
+ * \param[in] index_count  The number of indexes.
+ * \param[in] elements  The elements of an indexed mesh.
+ * \param[in] element_count  The number of elements.
+ */
+void mesh::restore(
+      mesh_format_t format
+    , double const * xy
+    , std::size_t point_count
+    , int const * indexes
+    , std::size_t index_count
+    , std::uint32_t const * elements
+    , std::size_t element_count)
+{
+    if(!f_points.empty())
+    {
+        throw std::logic_error("mesh::restore() called on a mesh which already has points.");
+    }
+
+    f_format = format;
+    f_points.reserve(point_count);
+    for(std::size_t idx(0); idx < point_count; ++idx)
+    {
+        add_point(point(xy[idx * 2], xy[idx * 2 + 1]));
+    }
+    f_indexes.assign(indexes, indexes + index_count);
+    f_elements.assign(elements, elements + element_count);
+}
+
+
+/** \brief Mark this mesh as a placeholder.
+ *
+ * When the font generates meshes in the background, it can return a
+ * simple quad covering the glyph bounding box until the real mesh is
+ * ready. Such a mesh is marked as a placeholder so the caller knows to
+ * fetch the mesh again later.
+ *
+ * \param[in] placeholder  Whether this mesh is a placeholder.
+ */
+void mesh::set_placeholder(bool placeholder)
+{
+    f_placeholder = placeholder;
+}
+
+
+bool mesh::is_placeholder() const
+{
+    return f_placeholder;
+}
+
+
+mesh::component_vector_t const & mesh::get_components() const
+{
+    return f_components;
+}
+
+
 } // namespace ftmesh
 // vim: ts=4 sw=4 et
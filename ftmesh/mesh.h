@@ -29,11 +29,13 @@
 
 // self
 //
-#include    "point.h"
+#include    "box.h"
+#include    "slab.h"
 
 
 // C++
 //
+#include    <cstdint>
 #include    <deque>
 #include    <map>
 
@@ -42,31 +44,95 @@ namespace ftmesh
 {
 
 
+constexpr std::size_t const DEFAULT_VERTEX_CACHE_SIZE = 16;
+constexpr std::uint32_t const PRIMITIVE_RESTART_INDEX = 0xFFFFFFFF;
+
+
+enum class mesh_format_t
+{
+    MESH_FORMAT_TRIANGLES,              // GL_TRIANGLES, one point per vertex
+    MESH_FORMAT_INDEXED_TRIANGLES,      // GL_TRIANGLES with elements
+    MESH_FORMAT_TRIANGLE_STRIPS,        // GL_TRIANGLE_STRIP with elements & primitive restart
+};
+
+
 class mesh
 {
 public:
     typedef std::shared_ptr<mesh>           pointer_t;
     typedef std::deque<pointer_t>           deque_t;
     typedef std::map<char32_t, pointer_t>   map_t;
-    typedef std::vector<int>                index_vector_t;
+
+    // the data of a mesh may be allocated in a slab (see copy())
+    //
+    typedef std::pmr::vector<point>         point_vector_t;
+    typedef std::pmr::vector<int>           index_vector_t;
+    typedef std::pmr::vector<std::uint32_t> element_vector_t;
     //typedef std::vector<GLenum>             type_vector_t;
 
-                                mesh(float advance);
+    // a composite glyph references other meshes with an affine transform
+    // (xx, xy, yx, yy, dx, dy) as in:
+    //
+    //     x' = xx * x + xy * y + dx
+    //     y' = yx * x + yy * y + dy
+    //
+    struct component
+    {
+        point                   transform(point const & p) const;
+
+        pointer_t               f_mesh = pointer_t();
+        double                  f_matrix[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+    };
+    typedef std::vector<component>          component_vector_t;
+
+                                mesh(float advance, slab::pointer_t storage = slab::pointer_t());
 
     void                        begin();
     void                        add_point(point const & point);
     void                        end();
+    void                        optimize(
+                                      mesh_format_t format
+                                    , std::size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+    void                        set_bearing(float x, float y);
+    void                        set_placeholder(bool placeholder);
+    void                        add_component(component const & c);
+    pointer_t                   flatten() const;
+    pointer_t                   copy(slab::pointer_t storage) const;
+    void                        restore(
+                                      mesh_format_t format
+                                    , double const * xy
+                                    , std::size_t point_count
+                                    , int const * indexes
+                                    , std::size_t index_count
+                                    , std::uint32_t const * elements
+                                    , std::size_t element_count);
 
-    point::vector_t const &     get_points() const;
+    mesh_format_t               get_format() const;
+    point_vector_t const &      get_points() const;
     index_vector_t const &      get_indexes() const;
+    element_vector_t const &    get_elements() const;
     //type_vector_t const &       get_types() const;
     float                       get_advance() const;
+    float                       get_bearing_x() const;
+    float                       get_bearing_y() const;
+    box const &                 get_bounds() const;
+    bool                        is_composite() const;
+    bool                        is_placeholder() const;
+    component_vector_t const &  get_components() const;
 
 private:
-    point::vector_t             f_points = point::vector_t();
+    slab::pointer_t             f_slab = slab::pointer_t();     // must be first
+    point_vector_t              f_points = point_vector_t();
     index_vector_t              f_indexes = index_vector_t();
+    element_vector_t            f_elements = element_vector_t();
     //type_vector_t               f_type = type_vector_t();
+    mesh_format_t               f_format = mesh_format_t::MESH_FORMAT_TRIANGLES;
     float                       f_advance = 0;
+    float                       f_bearing_x = 0;
+    float                       f_bearing_y = 0;
+    box                         f_bounds = box();
+    component_vector_t          f_components = component_vector_t();
+    bool                        f_placeholder = false;
 };
 
 
@@ -46,9 +46,13 @@ namespace ftmesh
 {
 
 
-mesh_char::mesh_char(mesh::pointer_t mesh, float advance)
+mesh_char::mesh_char(
+          mesh::pointer_t mesh
+        , float advance
+        , char32_t code_point)
     : f_mesh(mesh)
     , f_advance(advance)
+    , f_code_point(code_point)
 {
 }
 
@@ -65,5 +69,19 @@ float mesh_char::get_advance() const
 }
 
 
+/** \brief Get the character this mesh represents.
+ *
+ * The font::convert_string() function saves the code point of each
+ * character so the string can later be modified (i.e. truncated) with
+ * the correct kerning.
+ *
+ * \return The code point or U'\\0' if it was not specified.
+ */
+char32_t mesh_char::get_code_point() const
+{
+    return f_code_point;
+}
+
+
 } // namespace ftmesh
 // vim: ts=4 sw=4 et
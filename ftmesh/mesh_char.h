@@ -41,14 +41,19 @@ public:
     typedef std::shared_ptr<mesh_char>      pointer_t;
     typedef std::vector<pointer_t>          vector_t;
 
-                            mesh_char(mesh::pointer_t mesh, float advance);
+                            mesh_char(
+                                  mesh::pointer_t mesh
+                                , float advance
+                                , char32_t code_point = U'\0');
 
     mesh::pointer_t         get_mesh() const;
     float                   get_advance() const;
+    char32_t                get_code_point() const;
 
 private:
     mesh::pointer_t         f_mesh = mesh::pointer_t();
-    int                     f_advance = 0;
+    float                   f_advance = 0.0f;
+    char32_t                f_code_point = U'\0';
 };
 
 
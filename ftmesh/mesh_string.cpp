@@ -35,6 +35,12 @@
 #include    "ftmesh/mesh_string.h"
 
 
+// C++
+//
+#include    <algorithm>
+#include    <stdexcept>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -45,9 +51,189 @@ namespace ftmesh
 {
 
 
-void mesh_string::add_glyph(mesh::pointer_t mesh, float advance)
+/** \brief Append a glyph to the string.
+ *
+ * The glyph gets added at the end of the string. Along the glyph, the
+ * string keeps the offset where each glyph starts (the sum of the
+ * advances of all the glyphs before it) so the position queries do not
+ * have to walk the whole string.
+ *
+ * \param[in] mesh  The mesh of the glyph.
+ * \param[in] advance  The advance to the next glyph, kerning included.
+ * \param[in] code_point  The character represented by \p mesh.
+ */
+void mesh_string::add_glyph(
+      mesh::pointer_t mesh
+    , float advance
+    , char32_t code_point)
+{
+    float const x(f_offsets.back());
+    f_chars.push_back(std::make_shared<mesh_char>(mesh, advance, code_point));
+    f_bounds.add_box(mesh->get_bounds(), x, 0.0);
+    f_offsets.push_back(x + advance);
+}
+
+
+/** \brief Reserve space for \p size glyphs.
+ *
+ * \param[in] size  The number of glyphs expected in the string.
+ */
+void mesh_string::reserve(std::size_t size)
+{
+    f_chars.reserve(size);
+    f_offsets.reserve(size + 1);
+}
+
+
+/** \brief Get the number of glyphs in the string.
+ *
+ * \return The number of glyphs.
+ */
+std::size_t mesh_string::size() const
+{
+    return f_chars.size();
+}
+
+
+/** \brief Check whether the string has no glyphs.
+ *
+ * \return true if the string is empty.
+ */
+bool mesh_string::empty() const
+{
+    return f_chars.empty();
+}
+
+
+/** \brief Get one glyph of the string.
+ *
+ * The glyphs can only be added with add_glyph() so the offsets and the
+ * bounds of the string remain in sync with its glyphs.
+ *
+ * \param[in] index  The index of the glyph, which must be less than size().
+ *
+ * \return The glyph at \p index.
+ */
+mesh_char::pointer_t const & mesh_string::operator [] (std::size_t index) const
+{
+    return f_chars[index];
+}
+
+
+/** \brief Get the last glyph of the string.
+ *
+ * The string must not be empty.
+ *
+ * \return The last glyph.
+ */
+mesh_char::pointer_t const & mesh_string::back() const
+{
+    return f_chars.back();
+}
+
+
+mesh_string::const_iterator mesh_string::begin() const
+{
+    return f_chars.begin();
+}
+
+
+mesh_string::const_iterator mesh_string::end() const
+{
+    return f_chars.end();
+}
+
+
+/** \brief Get the total advance of the string.
+ *
+ * This is the sum of all the advances, kerning included. It is the
+ * same value as font::string_width() returns for the same string.
+ *
+ * \return The width of the string.
+ */
+float mesh_string::get_width() const
+{
+    return f_offsets.back();
+}
+
+
+/** \brief Get the ink bounding box of the whole string.
+ *
+ * The box is the union of the bounding box of each glyph offset by
+ * its position in the string. It gets updated each time a glyph is
+ * added so it is available without scanning the vertices.
+ *
+ * \return The bounding box of the string.
+ */
+box const & mesh_string::get_bounds() const
+{
+    return f_bounds;
+}
+
+
+/** \brief Get the position of the caret in front of a character.
+ *
+ * The position of the caret in front of the first character is 0.
+ * Using size() as the \p index returns the position after the last
+ * character, which is the width of the string.
+ *
+ * \exception std::out_of_range
+ * The \p index is larger than size().
+ *
+ * \param[in] index  The index of the character.
+ *
+ * \return The horizontal position of the caret.
+ */
+float mesh_string::get_caret_position(std::size_t index) const
+{
+    if(index >= f_offsets.size())
+    {
+        throw std::out_of_range(
+                  "caret index "
+                + std::to_string(index)
+                + " is out of range (string size is "
+                + std::to_string(size())
+                + ").");
+    }
+    return f_offsets[index];
+}
+
+
+/** \brief Find the character at position \p x.
+ *
+ * This function runs a binary search on the offsets of the glyphs to
+ * find the character which covers \p x. A position before the string
+ * returns 0 and a position after the string returns size().
+ *
+ * \param[in] x  The horizontal position to search.
+ *
+ * \return The index of the character at \p x.
+ */
+std::size_t mesh_string::hit_test(float x) const
+{
+    if(x < 0.0f)
+    {
+        return 0;
+    }
+    auto it(std::upper_bound(f_offsets.begin(), f_offsets.end(), x));
+    return std::distance(f_offsets.begin(), it) - 1;
+}
+
+
+/** \brief Find how many characters fit in \p width.
+ *
+ * This function returns the number of characters, starting from the
+ * first one, which have their advances sum up to at most \p width.
+ *
+ * \param[in] width  The available width.
+ *
+ * \return The number of characters which fit, size() if all fit.
+ */
+std::size_t mesh_string::fit_width(float width) const
 {
-    push_back(std::make_shared<mesh_char>(mesh, advance));
+    // the character found at `width` is the first one which does not fit
+    //
+    return hit_test(width);
 }
 
 
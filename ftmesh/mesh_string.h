@@ -42,14 +42,39 @@ namespace ftmesh
 
 
 class mesh_string
-    : public mesh_char::vector_t
 {
 public:
     typedef std::shared_ptr<mesh_string>  pointer_t;
+    typedef std::shared_ptr<mesh_string const>
+                                          const_pointer_t;
+    typedef mesh_char::vector_t::const_iterator
+                                          const_iterator;
 
-    void                    add_glyph(mesh::pointer_t mesh, float advance);
+    void                    add_glyph(
+                                  mesh::pointer_t mesh
+                                , float advance
+                                , char32_t code_point = U'\0');
+    void                    reserve(std::size_t size);
+
+    std::size_t             size() const;
+    bool                    empty() const;
+    mesh_char::pointer_t const &
+                            operator [] (std::size_t index) const;
+    mesh_char::pointer_t const &
+                            back() const;
+    const_iterator          begin() const;
+    const_iterator          end() const;
+
+    float                   get_width() const;
+    box const &             get_bounds() const;
+    float                   get_caret_position(std::size_t index) const;
+    std::size_t             hit_test(float x) const;
+    std::size_t             fit_width(float width) const;
 
 private:
+    mesh_char::vector_t     f_chars = mesh_char::vector_t();
+    std::vector<float>      f_offsets = std::vector<float>(1, 0.0f);
+    box                     f_bounds = box();
 };
 
 
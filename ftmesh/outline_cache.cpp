@@ -0,0 +1,197 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the outline_cache class.
+ *
+ * Different glyphs often have the exact same outline: fullwidth forms,
+ * duplicated glyphs in large CJK fonts, and, in a font collection, the
+ * glyphs shared by several faces. The key of the cache is a 64 bit hash
+ * of the font settings and of the outline (see
+ * font_impl::get_outline_key()) along the advance and the number of
+ * contours and points of the outline. Keeping the whole outline in the
+ * key would use about as much memory as the meshes themselves.
+ *
+ * The cache does not own the meshes. An outline remains in the cache
+ * as long as one of the fonts keeps its mesh, so dropping the meshes of
+ * a variant (see font::set_variation()) also frees them here.
+ *
+ * The fonts of a font_collection share one cache and may be used from
+ * different threads so the cache has its own mutex.
+ *
+ * \private
+ */
+
+
+// self
+//
+#include    <ftmesh/outline_cache.h>
+
+
+// C++
+//
+#include    <algorithm>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+namespace
+{
+
+
+// the expired entries get removed once the map doubled in size, but
+// not before it reaches this many entries
+//
+constexpr std::size_t const MINIMUM_PURGE_SIZE = 256;
+
+
+} // no name namespace
+
+
+
+bool outline_cache::key::operator == (key const & rhs) const
+{
+    return f_hash == rhs.f_hash
+        && f_advance == rhs.f_advance
+        && f_contours == rhs.f_contours
+        && f_points == rhs.f_points;
+}
+
+
+std::size_t outline_cache::key_hash::operator () (key const & k) const
+{
+    return static_cast<std::size_t>(k.f_hash);
+}
+
+
+/** \brief Add \p size bytes to the hash of a key.
+ *
+ * The hash is a 64 bit FNV-1a.
+ *
+ * \param[in,out] k  The key being computed.
+ * \param[in] data  The bytes to add.
+ * \param[in] size  The number of bytes in \p data.
+ */
+void outline_cache::hash(key & k, void const * data, std::size_t size)
+{
+    std::uint8_t const * d(reinterpret_cast<std::uint8_t const *>(data));
+    for(std::size_t idx(0); idx < size; ++idx)
+    {
+        k.f_hash ^= d[idx];
+        k.f_hash *= 1099511628211ULL;
+    }
+}
+
+
+/** \brief Search a mesh by outline.
+ *
+ * \param[in] k  The settings and outline key.
+ *
+ * \return The mesh or nullptr if this outline was not tessellated yet.
+ */
+mesh::pointer_t outline_cache::find(key const & k) const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    auto it(f_meshes.find(k));
+    if(it == f_meshes.end())
+    {
+        return mesh::pointer_t();
+    }
+    return it->second.lock();
+}
+
+
+/** \brief Save the mesh of an outline.
+ *
+ * Two fonts may tessellate the same outline at the same time. In that
+ * case, the first mesh added is kept and returned so both fonts end up
+ * sharing it.
+ *
+ * \param[in] k  The settings and outline key.
+ * \param[in] m  The mesh generated from that outline.
+ *
+ * \return The mesh now saved in the cache.
+ */
+mesh::pointer_t outline_cache::add(key const & k, mesh::pointer_t m)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    auto const r(f_meshes.emplace(k, m));
+    if(!r.second)
+    {
+        mesh::pointer_t const existing(r.first->second.lock());
+        if(existing != nullptr)
+        {
+            return existing;
+        }
+        r.first->second = m;
+    }
+    else if(f_meshes.size() >= f_purge_size)
+    {
+        for(auto it(f_meshes.begin()); it != f_meshes.end(); )
+        {
+            if(it->second.expired())
+            {
+                it = f_meshes.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        f_purge_size = std::max(f_meshes.size() * 2, MINIMUM_PURGE_SIZE);
+    }
+
+    return m;
+}
+
+
+/** \brief Get the number of outlines in the cache.
+ *
+ * \return The number of meshes saved in this cache and still in use.
+ */
+std::size_t outline_cache::size() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    return std::count_if(
+              f_meshes.begin()
+            , f_meshes.end()
+            , [](auto const & m)
+              {
+                  return !m.second.expired();
+              });
+}
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,93 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the outline_cache class.
+ *
+ * The outline cache maps glyph outlines to their meshes so identical
+ * outlines get tessellated only once, even between the faces of a
+ * font collection. The outlines are identified by a hash so the cache
+ * does not keep a copy of each outline, and the meshes are weak
+ * references so the cache does not keep them alive.
+ *
+ * \private
+ */
+
+
+// self
+//
+#include    <ftmesh/mesh.h>
+
+
+// C++
+//
+#include    <cstdint>
+#include    <mutex>
+#include    <unordered_map>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+class outline_cache
+{
+public:
+    typedef std::shared_ptr<outline_cache>  pointer_t;
+
+    struct key
+    {
+        bool                operator == (key const & rhs) const;
+
+        std::uint64_t       f_hash = FNV_OFFSET_BASIS;
+        std::int64_t        f_advance = 0;
+        std::int32_t        f_contours = 0;
+        std::int32_t        f_points = 0;
+    };
+
+    static constexpr std::uint64_t const FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+    static void             hash(key & k, void const * data, std::size_t size);
+
+    mesh::pointer_t         find(key const & k) const;
+    mesh::pointer_t         add(key const & k, mesh::pointer_t m);
+    std::size_t             size() const;
+
+private:
+    struct key_hash
+    {
+        std::size_t         operator () (key const & k) const;
+    };
+    typedef std::unordered_map<key, std::weak_ptr<mesh>, key_hash>
+                            mesh_map_t;
+
+    mutable std::mutex      f_mutex = std::mutex();
+    mesh_map_t              f_meshes = mesh_map_t();
+    std::size_t             f_purge_size = 0;
+};
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -36,6 +36,7 @@
 //
 #include    <algorithm>
 #include    <iostream>
+#include    <vector>
 
 
 // last include
@@ -54,6 +55,94 @@ constexpr unsigned int const        BEZIER_STEPS = 5;
 
 
 
+namespace
+{
+
+
+/** \brief Check whether point \p b is the tip of a zero width spike.
+ *
+ * A spike goes out and comes back on itself. Its tip can be removed
+ * without changing the area covered by the contour by more than
+ * \p tolerance. This happens when:
+ *
+ * \li \p a and \p c are near duplicates;
+ * \li \p b is within \p tolerance of the line going through \p a and
+ *     \p c but outside of the segment (a, c), i.e. the contour
+ *     backtracks on itself.
+ *
+ * Points sitting between \p a and \p c are not considered here. Those
+ * are handled by the Douglas-Peucker pass of polygon::simplify() which
+ * bounds the distance between each removed point and the final contour.
+ *
+ * \param[in] a  The point before \p b.
+ * \param[in] b  The point being checked.
+ * \param[in] c  The point after \p b.
+ * \param[in] tolerance  The maximum distance considered to be zero.
+ *
+ * \return true if \p b can be dropped.
+ */
+bool is_spike(
+          point const & a
+        , point const & b
+        , point const & c
+        , double tolerance)
+{
+    point const ab(b - a);
+    point const ac(c - a);
+
+    double const tolerance2(tolerance * tolerance);
+    double const length2(ac.x() * ac.x() + ac.y() * ac.y());
+    if(length2 <= tolerance2)
+    {
+        return true;
+    }
+
+    // distance of b to the (a, c) line is |cross(ab, ac)| / |ac|
+    //
+    double const cross(ab.x() * ac.y() - ab.y() * ac.x());
+    if(cross * cross > tolerance2 * length2)
+    {
+        return false;
+    }
+
+    double const dot(ab.x() * ac.x() + ab.y() * ac.y());
+    return dot < 0.0 || dot > length2;
+}
+
+
+/** \brief Compute the square of the distance from \p p to a segment.
+ *
+ * \param[in] p  The point to check.
+ * \param[in] a  The start of the segment.
+ * \param[in] b  The end of the segment.
+ *
+ * \return The square of the distance between \p p and segment (a, b).
+ */
+double segment_distance2(
+          point const & p
+        , point const & a
+        , point const & b)
+{
+    point const ab(b - a);
+    point const ap(p - a);
+
+    double const length2(ab.x() * ab.x() + ab.y() * ab.y());
+    double t(0.0);
+    if(length2 > 0.0)
+    {
+        t = std::clamp((ap.x() * ab.x() + ap.y() * ab.y()) / length2, 0.0, 1.0);
+    }
+    double const dx(ap.x() - ab.x() * t);
+    double const dy(ap.y() - ab.y() * t);
+    return dx * dx + dy * dy;
+}
+
+
+} // no name namespace
+
+
+
+
 
 
 polygon::polygon(
@@ -254,6 +343,140 @@ void polygon::apply_parity(int parity)
 }
 
 
+/** \brief Remove points which do not contribute to the contour.
+ *
+ * The curve evaluation and the FreeType outlines both generate points
+ * that are near duplicates or sit on a straight line between their
+ * neighbors (i.e. the stem of an "l" often has several points along
+ * the same vertical line). Each one of these points generates at least
+ * one additional triangle in the tessellation.
+ *
+ * This function first drops zero width spikes. Then it runs the
+ * Douglas-Peucker algorithm on the closed contour: a point is only
+ * removed if it is within \p tolerance of the segment which replaces
+ * it in the final contour. Checking against the final segment, and
+ * not just the current neighbors, is what prevents a long run of
+ * points along a gentle curve from being replaced by a chord that
+ * moves the shape by more than \p tolerance.
+ *
+ * If the polygon ends up with less than 3 points, it is degenerate
+ * and the caller is expected to ignore it.
+ *
+ * \param[in] tolerance  The maximum distance, in outline units, between
+ * a removed point and the simplified contour. Use 0.0 to skip the cleanup.
+ */
+void polygon::simplify(double tolerance)
+{
+    if(tolerance <= 0.0)
+    {
+        return;
+    }
+
+    // removing one spike may expose another so repeat until stable
+    //
+    bool changed(true);
+    while(changed && f_points.size() >= 3)
+    {
+        changed = false;
+        for(int idx(0); idx < static_cast<int>(f_points.size()) && f_points.size() >= 3;)
+        {
+            if(is_spike(at(idx - 1), at(idx), at(idx + 1), tolerance))
+            {
+                f_points.erase(f_points.begin() + idx);
+                changed = true;
+            }
+            else
+            {
+                ++idx;
+            }
+        }
+    }
+
+    std::size_t const max(f_points.size());
+    if(max >= 3)
+    {
+        // the contour is closed so split it in two chains using the
+        // point farthest from the first one as the second anchor
+        //
+        double const tolerance2(tolerance * tolerance);
+        std::size_t anchor(0);
+        double farthest(0.0);
+        for(std::size_t idx(1); idx < max; ++idx)
+        {
+            point const d(f_points[idx] - f_points[0]);
+            double const length2(d.x() * d.x() + d.y() * d.y());
+            if(length2 > farthest)
+            {
+                farthest = length2;
+                anchor = idx;
+            }
+        }
+
+        std::vector<bool> keep(max, false);
+        keep[0] = true;
+        if(farthest > tolerance2)
+        {
+            keep[anchor] = true;
+
+            // the chains are [first, last] where last == max means the
+            // first point again
+            //
+            std::vector<std::pair<std::size_t, std::size_t>> chains{
+                  { 0, anchor }
+                , { anchor, max }
+            };
+            while(!chains.empty())
+            {
+                auto const [first, last] = chains.back();
+                chains.pop_back();
+
+                point const & a(f_points[first]);
+                point const & b(f_points[last % max]);
+                std::size_t split(first);
+                double distance(tolerance2);
+                for(std::size_t idx(first + 1); idx < last; ++idx)
+                {
+                    double const d(segment_distance2(f_points[idx], a, b));
+                    if(d > distance)
+                    {
+                        distance = d;
+                        split = idx;
+                    }
+                }
+                if(split != first)
+                {
+                    keep[split] = true;
+                    chains.emplace_back(first, split);
+                    chains.emplace_back(split, last);
+                }
+            }
+        }
+
+        std::size_t j(0);
+        for(std::size_t idx(0); idx < max; ++idx)
+        {
+            if(keep[idx])
+            {
+                f_points[j] = f_points[idx];
+                ++j;
+            }
+        }
+        f_points.resize(j);
+    }
+
+    // the leftmost point may have been removed
+    //
+    f_leftmost = point(65536.0, 0.0);
+    for(auto const & p : f_points)
+    {
+        if(p.is_left_of(f_leftmost))
+        {
+            f_leftmost = p;
+        }
+    }
+}
+
+
 
 } // namespace ftmesh
 // vim: ts=4 sw=4 et
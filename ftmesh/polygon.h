@@ -65,6 +65,7 @@ public:
     point const &           at(int idx) const;
     point const &           leftmost() const;
     void                    apply_parity(int parity);
+    void                    simplify(double tolerance);
 
 private:
     void                    add_point(point const & p);
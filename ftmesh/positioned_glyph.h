@@ -0,0 +1,53 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the positioned_glyph structure.
+ *
+ * A mesh_string only holds the advance of each glyph so the position of
+ * a glyph depends on all the glyphs before it. When text is processed
+ * in batches or laid out on multiple lines, each glyph is instead given
+ * its absolute position.
+ */
+
+// self
+//
+#include    <ftmesh/mesh.h>
+
+
+namespace ftmesh
+{
+
+
+
+struct positioned_glyph
+{
+    typedef std::vector<positioned_glyph>   vector_t;
+
+    mesh::pointer_t     f_mesh = mesh::pointer_t();
+    char32_t            f_code_point = U'\0';
+    float               f_x = 0.0f;
+    float               f_y = 0.0f;
+};
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,56 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the shaped_glyph structure.
+ *
+ * A shaper (i.e. HarfBuzz) converts a string of characters into a list
+ * of glyph indexes with their advance and offset. The ligatures, marks
+ * and contextual forms are already resolved so the glyphs are not
+ * associated to one code point anymore.
+ */
+
+// C++
+//
+#include    <cstdint>
+#include    <vector>
+
+
+namespace ftmesh
+{
+
+
+
+struct shaped_glyph
+{
+    typedef std::vector<shaped_glyph>   vector_t;
+
+    std::uint32_t       f_index = 0;
+    char32_t            f_code_point = U'\0';
+    float               f_x_advance = 0.0f;
+    float               f_y_advance = 0.0f;
+    float               f_x_offset = 0.0f;
+    float               f_y_offset = 0.0f;
+};
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,567 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the shared_cache class.
+ *
+ * The segment is created with shm_open() and mapped in each process,
+ * possibly at a different address, so it only uses offsets, never
+ * pointers. It starts with a header followed by a hash table of slots
+ * and the records:
+ *
+ * \code
+ *     header | slot[0] ... slot[n - 1] | record | record | ...
+ * \endcode
+ *
+ * Each slot holds the offset of a record or 0 when empty. A record holds
+ * the key and the arrays of one mesh. A process adding a mesh reserves
+ * the space of its record by atomically incrementing the \p f_next
+ * offset of the header, writes the record, and then publishes it by
+ * setting an empty slot with a compare-and-swap. Records are never
+ * modified or removed once published so readers need no lock. When the
+ * segment is full, new meshes are simply not shared.
+ *
+ * The atomics used are lock free, which also makes them address free,
+ * a requirement for atomics shared between processes.
+ *
+ * \private
+ */
+
+// self
+//
+#include    "ftmesh/shared_cache.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <atomic>
+#include    <cerrno>
+#include    <chrono>
+#include    <cstring>
+#include    <stdexcept>
+#include    <thread>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <sys/mman.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free
+            , "the shared cache requires lock free 64 bit atomics");
+
+
+constexpr std::uint32_t const SHARED_CACHE_MAGIC = 0x4D534846;     // "FHSM"
+constexpr std::uint32_t const SHARED_CACHE_VERSION = 1;
+
+
+struct shared_cache_header
+{
+    std::atomic<std::uint32_t>  f_magic;
+    std::uint32_t               f_version;
+    std::uint64_t               f_size;
+    std::uint64_t               f_slot_count;
+    std::atomic<std::uint64_t>  f_next;
+};
+
+
+struct shared_cache_record
+{
+    std::uint64_t               f_hash;
+    std::uint32_t               f_key_length;
+    std::uint32_t               f_format;
+    float                       f_advance;
+    float                       f_bearing_x;
+    float                       f_bearing_y;
+    std::uint32_t               f_point_count;
+    std::uint32_t               f_index_count;
+    std::uint32_t               f_element_count;
+
+    // followed by: key, doubles (x, y), int indexes, uint32 elements
+};
+
+
+namespace
+{
+
+
+std::size_t align8(std::size_t size)
+{
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+
+// FNV-1a
+//
+std::uint64_t hash_key(std::string_view key)
+{
+    std::uint64_t result(0xcbf29ce484222325ULL);
+    for(char const c : key)
+    {
+        result ^= static_cast<unsigned char>(c);
+        result *= 0x100000001b3ULL;
+    }
+    return result;
+}
+
+
+std::atomic<std::uint64_t> * get_slots(shared_cache_header * header)
+{
+    return reinterpret_cast<std::atomic<std::uint64_t> *>(
+                    reinterpret_cast<char *>(header) + align8(sizeof(shared_cache_header)));
+}
+
+
+char const * record_key(shared_cache_record const * r)
+{
+    return reinterpret_cast<char const *>(r) + align8(sizeof(shared_cache_record));
+}
+
+
+// the counts are 32 bits so this can't overflow a 64 bit size
+//
+std::uint64_t record_size(
+      std::uint64_t key_length
+    , std::uint64_t point_count
+    , std::uint64_t index_count
+    , std::uint64_t element_count)
+{
+    return align8(sizeof(shared_cache_record))
+         + align8(key_length)
+         + point_count * 2 * sizeof(double)
+         + align8(index_count * sizeof(int))
+         + align8(element_count * sizeof(std::uint32_t));
+}
+
+
+} // no name namespace
+
+
+
+/** \brief Open or create a shared memory cache.
+ *
+ * The first process to open the segment creates it and initializes
+ * the header. The other processes wait for the header to be ready.
+ *
+ * If the process which created the segment died before initializing
+ * it, the segment would remain unusable. In that case, it gets removed
+ * and created again.
+ *
+ * \exception std::runtime_error
+ * The segment could not be created, opened or mapped, or it exists with
+ * a different size or version.
+ *
+ * \param[in] name  The name of the segment, as in "/ftmesh-cache".
+ * \param[in] size  The size of the segment in bytes.
+ */
+shared_cache::shared_cache(std::string const & name, std::size_t size)
+    : f_name(name)
+    , f_size(size)
+{
+    if(size < 64 * 1024)
+    {
+        throw std::runtime_error("the shared cache must be at least 64Kb.");
+    }
+
+    // use about 1/64th of the segment for the slots; the count is not
+    // read back from the header since any process can write to it
+    //
+    f_slot_count = f_size / 64 / sizeof(std::uint64_t);
+    f_first_record = align8(sizeof(shared_cache_header))
+                   + f_slot_count * sizeof(std::uint64_t);
+
+    if(!open())
+    {
+        shm_unlink(f_name.c_str());
+        if(!open())
+        {
+            throw std::runtime_error(
+                      "shared memory segment \""
+                    + f_name
+                    + "\" was not initialized in time.");
+        }
+    }
+}
+
+
+/** \brief Open, or create and initialize, the segment.
+ *
+ * \exception std::runtime_error
+ * The segment could not be created, opened or mapped, or it exists with
+ * a different size or version.
+ *
+ * \return false if the segment exists but did not get initialized by
+ * its creator.
+ */
+bool shared_cache::open()
+{
+    bool created(true);
+    int fd(shm_open(f_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600));
+    if(fd < 0 && errno == EEXIST)
+    {
+        created = false;
+        fd = shm_open(f_name.c_str(), O_RDWR, 0600);
+    }
+    if(fd < 0)
+    {
+        throw std::runtime_error("could not open shared memory segment \"" + f_name + "\".");
+    }
+
+    if(created)
+    {
+        if(ftruncate(fd, static_cast<off_t>(f_size)) != 0)
+        {
+            close(fd);
+            shm_unlink(f_name.c_str());
+            throw std::runtime_error("could not resize shared memory segment \"" + f_name + "\".");
+        }
+    }
+    else
+    {
+        // the creator may not have resized the segment yet
+        //
+        struct stat st = {};
+        for(int retry(0); retry < 1000; ++retry)
+        {
+            if(fstat(fd, &st) == 0
+            && st.st_size != 0)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if(st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        if(static_cast<std::size_t>(st.st_size) != f_size)
+        {
+            close(fd);
+            throw std::runtime_error(
+                      "shared memory segment \""
+                    + f_name
+                    + "\" exists with a different size.");
+        }
+    }
+
+    f_data = mmap(nullptr, f_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(f_data == MAP_FAILED)
+    {
+        f_data = nullptr;
+        throw std::runtime_error("could not map shared memory segment \"" + f_name + "\".");
+    }
+    f_header = static_cast<shared_cache_header *>(f_data);
+
+    if(created)
+    {
+        f_header->f_version = SHARED_CACHE_VERSION;
+        f_header->f_size = f_size;
+        f_header->f_slot_count = f_slot_count;
+        f_header->f_next.store(f_first_record, std::memory_order_relaxed);
+        f_header->f_magic.store(SHARED_CACHE_MAGIC, std::memory_order_release);
+    }
+    else
+    {
+        for(int retry(0); retry < 1000; ++retry)
+        {
+            if(f_header->f_magic.load(std::memory_order_acquire) == SHARED_CACHE_MAGIC)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::uint32_t const magic(f_header->f_magic.load(std::memory_order_acquire));
+        if(magic == 0)
+        {
+            munmap(f_data, f_size);
+            f_data = nullptr;
+            f_header = nullptr;
+            return false;
+        }
+        if(magic != SHARED_CACHE_MAGIC
+        || f_header->f_version != SHARED_CACHE_VERSION
+        || f_header->f_size != f_size
+        || f_header->f_slot_count != f_slot_count)
+        {
+            munmap(f_data, f_size);
+            f_data = nullptr;
+            f_header = nullptr;
+            throw std::runtime_error(
+                      "shared memory segment \""
+                    + f_name
+                    + "\" is not a compatible ftmesh cache.");
+        }
+    }
+
+    return true;
+}
+
+
+/** \brief Unmap the segment.
+ *
+ * The segment itself is not removed since other processes may still
+ * use it. It gets removed with shm_unlink() or when the system restarts.
+ */
+shared_cache::~shared_cache()
+{
+    if(f_data != nullptr)
+    {
+        munmap(f_data, f_size);
+    }
+}
+
+
+/** \brief Get the record at \p offset.
+ *
+ * The offsets and the counts found in the segment can be written by any
+ * process with access to it. This function makes sure that the whole
+ * record, including its key and arrays, is within the segment.
+ *
+ * \param[in] offset  The offset of the record as found in a slot.
+ *
+ * \return The record or nullptr if it is not valid.
+ */
+shared_cache_record const * shared_cache::get_record(std::uint64_t offset) const
+{
+    if(offset < f_first_record
+    || (offset & 7) != 0
+    || offset > f_size
+    || f_size - offset < align8(sizeof(shared_cache_record)))
+    {
+        return nullptr;
+    }
+
+    shared_cache_record const * r(reinterpret_cast<shared_cache_record const *>(
+                                    static_cast<char const *>(f_data) + offset));
+    if(r->f_format > static_cast<std::uint32_t>(mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS)
+    || record_size(r->f_key_length, r->f_point_count, r->f_index_count, r->f_element_count) > f_size - offset)
+    {
+        return nullptr;
+    }
+
+    return r;
+}
+
+
+/** \brief Search a mesh in the shared cache.
+ *
+ * If found, the mesh is copied from the shared memory to a new mesh
+ * allocated in \p storage (or the heap if null). The copy is a plain
+ * memory copy, much faster than tessellating the glyph.
+ *
+ * \param[in] key  The key of the mesh.
+ * \param[in] storage  The slab where the mesh data gets allocated.
+ *
+ * \return The mesh or nullptr if not found.
+ */
+mesh::pointer_t shared_cache::find(std::string_view key, slab::pointer_t storage) const
+{
+    std::uint64_t const hash(hash_key(key));
+    std::atomic<std::uint64_t> * slots(get_slots(f_header));
+
+    for(std::uint64_t probe(0); probe < f_slot_count; ++probe)
+    {
+        std::uint64_t const offset(slots[(hash + probe) % f_slot_count].load(std::memory_order_acquire));
+        if(offset == 0)
+        {
+            return mesh::pointer_t();
+        }
+        shared_cache_record const * r(get_record(offset));
+        if(r == nullptr
+        || r->f_hash != hash
+        || r->f_key_length != key.length()
+        || std::memcmp(record_key(r), key.data(), key.length()) != 0)
+        {
+            continue;
+        }
+
+        char const * data(record_key(r) + align8(r->f_key_length));
+        double const * xy(reinterpret_cast<double const *>(data));
+        data += r->f_point_count * 2 * sizeof(double);
+        int const * indexes(reinterpret_cast<int const *>(data));
+        data += align8(r->f_index_count * sizeof(int));
+        std::uint32_t const * elements(reinterpret_cast<std::uint32_t const *>(data));
+
+        // the indexes and elements are used to access the points
+        //
+        if(std::any_of(
+                  indexes
+                , indexes + r->f_index_count
+                , [r](int i)
+                  {
+                      return i < 0 || static_cast<std::uint32_t>(i) > r->f_point_count;
+                  })
+        || std::any_of(
+                  elements
+                , elements + r->f_element_count
+                , [r](std::uint32_t e)
+                  {
+                      return e >= r->f_point_count && e != PRIMITIVE_RESTART_INDEX;
+                  }))
+        {
+            return mesh::pointer_t();
+        }
+
+        mesh::pointer_t result(std::make_shared<mesh>(r->f_advance, storage));
+        result->set_bearing(r->f_bearing_x, r->f_bearing_y);
+        result->restore(
+                  static_cast<mesh_format_t>(r->f_format)
+                , xy
+                , r->f_point_count
+                , indexes
+                , r->f_index_count
+                , elements
+                , r->f_element_count);
+        return result;
+    }
+
+    return mesh::pointer_t();
+}
+
+
+/** \brief Save a mesh in the shared cache.
+ *
+ * Composite meshes get flattened first since the shared cache only
+ * saves plain meshes.
+ *
+ * If another process published the same key first, this function
+ * returns true and the space reserved for the record is lost. This is
+ * rare and much simpler than a lock between processes.
+ *
+ * \param[in] key  The key of the mesh.
+ * \param[in] m  The mesh to save.
+ *
+ * \return true if the mesh is now in the cache, false if the cache
+ * is full.
+ */
+bool shared_cache::publish(std::string_view key, mesh::pointer_t m)
+{
+    if(m->is_composite())
+    {
+        m = m->flatten();
+    }
+
+    mesh::point_vector_t const & points(m->get_points());
+    mesh::index_vector_t const & indexes(m->get_indexes());
+    mesh::element_vector_t const & elements(m->get_elements());
+    std::uint64_t const size(record_size(
+                  key.length()
+                , points.size()
+                , indexes.size()
+                , elements.size()));
+
+    std::uint64_t const offset(f_header->f_next.fetch_add(size, std::memory_order_relaxed));
+    if(offset < f_first_record
+    || (offset & 7) != 0
+    || offset > f_size
+    || size > f_size - offset)
+    {
+        return false;
+    }
+
+    char * base(static_cast<char *>(f_data));
+    shared_cache_record * r(reinterpret_cast<shared_cache_record *>(base + offset));
+    std::uint64_t const hash(hash_key(key));
+    r->f_hash = hash;
+    r->f_key_length = static_cast<std::uint32_t>(key.length());
+    r->f_format = static_cast<std::uint32_t>(m->get_format());
+    r->f_advance = m->get_advance();
+    r->f_bearing_x = m->get_bearing_x();
+    r->f_bearing_y = m->get_bearing_y();
+    r->f_point_count = static_cast<std::uint32_t>(points.size());
+    r->f_index_count = static_cast<std::uint32_t>(indexes.size());
+    r->f_element_count = static_cast<std::uint32_t>(elements.size());
+
+    char * data(base + offset + align8(sizeof(shared_cache_record)));
+    std::memcpy(data, key.data(), key.length());
+    data += align8(key.length());
+    double * xy(reinterpret_cast<double *>(data));
+    for(auto const & p : points)
+    {
+        *xy++ = p.x();
+        *xy++ = p.y();
+    }
+    data = reinterpret_cast<char *>(xy);
+    std::copy(indexes.begin(), indexes.end(), reinterpret_cast<int *>(data));
+    data += align8(indexes.size() * sizeof(int));
+    std::copy(elements.begin(), elements.end(), reinterpret_cast<std::uint32_t *>(data));
+
+    // the release makes the record visible before its offset
+    //
+    std::atomic<std::uint64_t> * slots(get_slots(f_header));
+    for(std::uint64_t probe(0); probe < f_slot_count; ++probe)
+    {
+        std::atomic<std::uint64_t> & slot(slots[(hash + probe) % f_slot_count]);
+        std::uint64_t expected(0);
+        if(slot.compare_exchange_strong(
+                  expected
+                , offset
+                , std::memory_order_release
+                , std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        shared_cache_record const * other(get_record(expected));
+        if(other != nullptr
+        && other->f_hash == hash
+        && other->f_key_length == key.length()
+        && std::memcmp(record_key(other), key.data(), key.length()) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/** \brief Get the number of bytes used in the segment.
+ *
+ * \return The offset of the next record, which may be larger than the
+ * segment once it is full.
+ */
+std::size_t shared_cache::get_used() const
+{
+    return f_header->f_next.load(std::memory_order_relaxed);
+}
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,84 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the shared_cache class.
+ *
+ * The shared cache saves meshes in a named shared memory segment so
+ * several processes using the same fonts tessellate each glyph once.
+ *
+ * \private
+ */
+
+
+// self
+//
+#include    <ftmesh/mesh.h>
+
+
+// C++
+//
+#include    <string>
+#include    <string_view>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+struct shared_cache_header;
+struct shared_cache_record;
+
+
+class shared_cache
+{
+public:
+    typedef std::shared_ptr<shared_cache>   pointer_t;
+
+                            shared_cache(std::string const & name, std::size_t size);
+                            shared_cache(shared_cache const &) = delete;
+                            ~shared_cache();
+    shared_cache &          operator = (shared_cache const &) = delete;
+
+    mesh::pointer_t         find(std::string_view key, slab::pointer_t storage) const;
+    bool                    publish(std::string_view key, mesh::pointer_t m);
+    std::size_t             get_used() const;
+
+private:
+    bool                    open();
+    shared_cache_record const *
+                            get_record(std::uint64_t offset) const;
+
+    std::string const       f_name;
+    std::size_t             f_size = 0;
+    std::uint64_t           f_slot_count = 0;
+    std::uint64_t           f_first_record = 0;
+    void *                  f_data = nullptr;
+    shared_cache_header *   f_header = nullptr;
+};
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
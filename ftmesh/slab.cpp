@@ -0,0 +1,91 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the slab class.
+ *
+ * The slab allocates blocks of memory and hands out consecutive chunks
+ * of those blocks. Memory is never given back until the slab itself
+ * gets destroyed which is why it is only used for data which lives as
+ * long as a cache: the font gives one slab to each variant cache so
+ * evicting a variant releases the memory of its meshes.
+ *
+ * The slab is not thread safe. It is expected to be used by one font
+ * which serializes the creation of its meshes.
+ */
+
+// self
+//
+#include    "ftmesh/slab.h"
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+
+slab::slab(std::size_t initial_size)
+    : f_blocks(initial_size)
+{
+}
+
+
+/** \brief Get the number of bytes allocated from this slab.
+ *
+ * This is the sum of all the allocations, not the size of the blocks
+ * reserved by the slab.
+ *
+ * \return The number of bytes in use.
+ */
+std::size_t slab::get_used() const
+{
+    return f_used;
+}
+
+
+void * slab::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    f_used += bytes;
+    return f_blocks.allocate(bytes, alignment);
+}
+
+
+void slab::do_deallocate(void * p, std::size_t bytes, std::size_t alignment)
+{
+    // memory only gets released when the slab is destroyed
+    //
+    f_blocks.deallocate(p, bytes, alignment);
+}
+
+
+bool slab::do_is_equal(std::pmr::memory_resource const & other) const noexcept
+{
+    return this == &other;
+}
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
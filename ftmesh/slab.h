@@ -0,0 +1,66 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the slab class.
+ *
+ * The slab is an append-only memory resource. When a font uses a slab,
+ * the vertices and indexes of all its meshes get allocated one after
+ * the other in a few large blocks instead of two small heap blocks per
+ * glyph.
+ */
+
+// C++
+//
+#include    <memory>
+#include    <memory_resource>
+
+
+namespace ftmesh
+{
+
+
+constexpr std::size_t const DEFAULT_SLAB_SIZE = 64 * 1024;
+
+
+class slab
+    : public std::pmr::memory_resource
+{
+public:
+    typedef std::shared_ptr<slab>       pointer_t;
+
+                                slab(std::size_t initial_size = DEFAULT_SLAB_SIZE);
+
+    std::size_t                 get_used() const;
+
+protected:
+    virtual void *              do_allocate(std::size_t bytes, std::size_t alignment) override;
+    virtual void                do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override;
+    virtual bool                do_is_equal(std::pmr::memory_resource const & other) const noexcept override;
+
+private:
+    std::pmr::monotonic_buffer_resource
+                                f_blocks;
+    std::size_t                 f_used = 0;
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
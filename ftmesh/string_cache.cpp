@@ -0,0 +1,238 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/** \file
+ * \brief Implementation of the string_cache class.
+ *
+ * User interfaces convert the same labels every frame. This cache maps
+ * the bytes of a string, prefixed by the font settings, to the
+ * mesh_string or width computed for it.
+ *
+ * The entries are kept in a list ordered from the most recently used
+ * to the least recently used. The index is an unordered map of views on
+ * the keys saved in the list entries (list elements never move) to
+ * their position in the list. When the estimated memory used by the
+ * entries goes over the maximum size, the least recently used entries
+ * get removed.
+ *
+ * \private
+ */
+
+
+// self
+//
+#include    <ftmesh/string_cache.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+namespace
+{
+
+
+// rough size of a list node plus an unordered_map node
+//
+constexpr std::size_t const ENTRY_OVERHEAD = sizeof(void *) * 8;
+
+
+std::size_t estimate_size(std::string_view key, mesh_string::const_pointer_t const & s)
+{
+    std::size_t result(ENTRY_OVERHEAD + key.length());
+    if(s != nullptr)
+    {
+        // the meshes are shared with the font so they are not counted
+        //
+        result += sizeof(mesh_string)
+                + s->size() * (sizeof(mesh_char::pointer_t)
+                             + sizeof(mesh_char)
+                             + sizeof(float)
+                             + ENTRY_OVERHEAD / 2);
+    }
+    return result;
+}
+
+
+} // no name namespace
+
+
+
+/** \brief Set the maximum amount of memory used by the cache.
+ *
+ * The size is an estimate in bytes. Setting it to 0 disables the cache
+ * and releases all the entries.
+ *
+ * \param[in] max_size  The new maximum size.
+ */
+void string_cache::set_max_size(std::size_t max_size)
+{
+    f_max_size = max_size;
+    evict();
+}
+
+
+std::size_t string_cache::get_max_size() const
+{
+    return f_max_size;
+}
+
+
+std::size_t string_cache::get_size() const
+{
+    return f_size;
+}
+
+
+void string_cache::clear()
+{
+    f_index.clear();
+    f_entries.clear();
+    f_size = 0;
+}
+
+
+/** \brief Search the string with \p key.
+ *
+ * \param[in] key  The key of the string.
+ *
+ * \return The cached string or nullptr if there is none.
+ */
+mesh_string::const_pointer_t string_cache::find_string(std::string_view key)
+{
+    auto it(find(key));
+    if(it == f_entries.end())
+    {
+        return mesh_string::const_pointer_t();
+    }
+    return it->f_string;
+}
+
+
+/** \brief Search the width of the string with \p key.
+ *
+ * The width is available whether the entry was added with add_width()
+ * or add_string().
+ *
+ * \param[in] key  The key of the string.
+ * \param[out] width  The width found in the cache.
+ *
+ * \return true if the width was found.
+ */
+bool string_cache::find_width(std::string_view key, float & width)
+{
+    auto it(find(key));
+    if(it == f_entries.end())
+    {
+        return false;
+    }
+    width = it->f_width;
+    return true;
+}
+
+
+void string_cache::add_string(std::string_view key, mesh_string::const_pointer_t s)
+{
+    add(key, s, s->get_width());
+}
+
+
+void string_cache::add_width(std::string_view key, float width)
+{
+    add(key, mesh_string::const_pointer_t(), width);
+}
+
+
+string_cache::list_t::iterator string_cache::find(std::string_view key)
+{
+    auto it(f_index.find(key));
+    if(it == f_index.end())
+    {
+        return f_entries.end();
+    }
+
+    // move to the front, it is now the most recently used
+    //
+    f_entries.splice(f_entries.begin(), f_entries, it->second);
+    return it->second;
+}
+
+
+void string_cache::add(std::string_view key, mesh_string::const_pointer_t s, float width)
+{
+    if(f_max_size == 0)
+    {
+        return;
+    }
+
+    auto it(find(key));
+    if(it != f_entries.end())
+    {
+        // a width only entry gets upgraded with the string
+        //
+        if(it->f_string == nullptr
+        && s != nullptr)
+        {
+            std::size_t const size(estimate_size(key, s));
+            f_size += size - it->f_size;
+            it->f_string = s;
+            it->f_size = size;
+            evict();
+        }
+        return;
+    }
+
+    entry e;
+    e.f_key = key;
+    e.f_string = s;
+    e.f_width = width;
+    e.f_size = estimate_size(key, s);
+    f_size += e.f_size;
+    f_entries.push_front(std::move(e));
+    f_index[f_entries.front().f_key] = f_entries.begin();
+
+    evict();
+}
+
+
+void string_cache::evict()
+{
+    while(f_size > f_max_size
+       && !f_entries.empty())
+    {
+        entry const & e(f_entries.back());
+        f_size -= e.f_size;
+        f_index.erase(e.f_key);
+        f_entries.pop_back();
+    }
+}
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,90 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the string_cache class.
+ *
+ * The string cache keeps the result of font::convert_string() and
+ * font::string_width() for strings which get converted over and over.
+ *
+ * \private
+ */
+
+
+// self
+//
+#include    <ftmesh/mesh_string.h>
+
+
+// C++
+//
+#include    <list>
+#include    <string_view>
+#include    <unordered_map>
+
+
+
+namespace ftmesh
+{
+namespace detail
+{
+
+
+class string_cache
+{
+public:
+    void                    set_max_size(std::size_t max_size);
+    std::size_t             get_max_size() const;
+    std::size_t             get_size() const;
+    void                    clear();
+
+    mesh_string::const_pointer_t
+                            find_string(std::string_view key);
+    bool                    find_width(std::string_view key, float & width);
+    void                    add_string(std::string_view key, mesh_string::const_pointer_t s);
+    void                    add_width(std::string_view key, float width);
+
+private:
+    struct entry
+    {
+        std::string             f_key = std::string();
+        mesh_string::const_pointer_t
+                                f_string = mesh_string::const_pointer_t();
+        float                   f_width = 0.0f;
+        std::size_t             f_size = 0;
+    };
+    typedef std::list<entry>    list_t;
+
+    list_t::iterator        find(std::string_view key);
+    void                    add(std::string_view key, mesh_string::const_pointer_t s, float width);
+    void                    evict();
+
+    std::size_t             f_max_size = 0;
+    std::size_t             f_size = 0;
+    list_t                  f_entries = list_t();
+    std::unordered_map<std::string_view, list_t::iterator>
+                            f_index = std::unordered_map<std::string_view, list_t::iterator>();
+};
+
+
+
+} // namespace detail
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
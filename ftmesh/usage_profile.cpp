@@ -0,0 +1,261 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+
+/** \file
+ * \brief Implementation of the usage_profile class.
+ *
+ * The profile is saved as a text file with one entry per line:
+ *
+ * \code
+ *     # ftmesh usage profile
+ *     g <code point> <count>
+ *     k <code point> <code point> <count>
+ * \endcode
+ *
+ * The code points are written in hexadecimal. Lines starting with '#'
+ * and empty lines are ignored. The entries are sorted by decreasing
+ * count so the file can be truncated to keep only the most used ones.
+ */
+
+// self
+//
+#include    "ftmesh/usage_profile.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <fstream>
+#include    <sstream>
+#include    <stdexcept>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace ftmesh
+{
+
+
+namespace
+{
+
+
+std::uint64_t pair_key(char32_t current_char, char32_t next_char)
+{
+    return (static_cast<std::uint64_t>(current_char) << 32) | next_char;
+}
+
+
+} // no name namespace
+
+
+
+void usage_profile::record_glyph(char32_t glyph)
+{
+    ++f_glyphs[glyph];
+}
+
+
+void usage_profile::record_pair(char32_t current_char, char32_t next_char)
+{
+    ++f_pairs[pair_key(current_char, next_char)];
+}
+
+
+void usage_profile::clear()
+{
+    f_glyphs.clear();
+    f_pairs.clear();
+}
+
+
+/** \brief Get the characters sorted by decreasing usage.
+ *
+ * \param[in] max_count  The maximum number of characters to return,
+ * 0 to return all of them.
+ *
+ * \return The characters and their count, the most used first.
+ */
+usage_profile::glyph_count_vector_t usage_profile::get_glyphs(std::size_t max_count) const
+{
+    glyph_count_vector_t result;
+    result.reserve(f_glyphs.size());
+    for(auto const & g : f_glyphs)
+    {
+        result.push_back({ g.first, g.second });
+    }
+    std::sort(
+          result.begin()
+        , result.end()
+        , [](glyph_count const & a, glyph_count const & b)
+          {
+              return a.f_count != b.f_count
+                    ? a.f_count > b.f_count
+                    : a.f_glyph < b.f_glyph;
+          });
+    if(max_count != 0
+    && result.size() > max_count)
+    {
+        result.resize(max_count);
+    }
+    return result;
+}
+
+
+/** \brief Get the kerning pairs sorted by decreasing usage.
+ *
+ * \param[in] max_count  The maximum number of pairs to return, 0 to
+ * return all of them.
+ *
+ * \return The pairs and their count, the most used first.
+ */
+usage_profile::pair_count_vector_t usage_profile::get_pairs(std::size_t max_count) const
+{
+    pair_count_vector_t result;
+    result.reserve(f_pairs.size());
+    for(auto const & p : f_pairs)
+    {
+        result.push_back({
+                  static_cast<char32_t>(p.first >> 32)
+                , static_cast<char32_t>(p.first & 0xFFFFFFFF)
+                , p.second });
+    }
+    std::sort(
+          result.begin()
+        , result.end()
+        , [](pair_count const & a, pair_count const & b)
+          {
+              if(a.f_count != b.f_count)
+              {
+                  return a.f_count > b.f_count;
+              }
+              return pair_key(a.f_current, a.f_next) < pair_key(b.f_current, b.f_next);
+          });
+    if(max_count != 0
+    && result.size() > max_count)
+    {
+        result.resize(max_count);
+    }
+    return result;
+}
+
+
+/** \brief Save the profile to a file.
+ *
+ * \exception std::runtime_error
+ * The file could not be written.
+ *
+ * \param[in] filename  The name of the file to create.
+ * \param[in] max_count  Save at most that many characters and that many
+ * pairs, the most used ones; 0 saves everything.
+ */
+void usage_profile::save(std::string const & filename, std::size_t max_count) const
+{
+    std::ofstream out(filename);
+    if(!out)
+    {
+        throw std::runtime_error("could not create usage profile \"" + filename + "\".");
+    }
+
+    out << "# ftmesh usage profile\n" << std::hex;
+    for(auto const & g : get_glyphs(max_count))
+    {
+        out << "g " << static_cast<std::uint32_t>(g.f_glyph)
+            << ' ' << std::dec << g.f_count << std::hex << '\n';
+    }
+    for(auto const & p : get_pairs(max_count))
+    {
+        out << "k " << static_cast<std::uint32_t>(p.f_current)
+            << ' ' << static_cast<std::uint32_t>(p.f_next)
+            << ' ' << std::dec << p.f_count << std::hex << '\n';
+    }
+
+    if(!out)
+    {
+        throw std::runtime_error("could not write usage profile \"" + filename + "\".");
+    }
+}
+
+
+/** \brief Load a profile saved with save().
+ *
+ * The counts read from the file are added to the counts already in
+ * this profile.
+ *
+ * \exception std::runtime_error
+ * The file could not be opened or includes an invalid line.
+ *
+ * \param[in] filename  The name of the file to read.
+ */
+void usage_profile::load(std::string const & filename)
+{
+    std::ifstream in(filename);
+    if(!in)
+    {
+        throw std::runtime_error("could not open usage profile \"" + filename + "\".");
+    }
+
+    std::string line;
+    for(int line_number(1); std::getline(in, line); ++line_number)
+    {
+        if(line.empty()
+        || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string type;
+        std::uint32_t current(0);
+        std::uint32_t next(0);
+        std::uint64_t count(0);
+        fields >> type >> std::hex >> current;
+        if(type == "k")
+        {
+            fields >> next;
+        }
+        fields >> std::dec >> count;
+        if(!fields
+        || (type != "g" && type != "k"))
+        {
+            throw std::runtime_error(
+                      "invalid line "
+                    + std::to_string(line_number)
+                    + " in usage profile \""
+                    + filename
+                    + "\".");
+        }
+
+        if(type == "g")
+        {
+            f_glyphs[current] += count;
+        }
+        else
+        {
+            f_pairs[pair_key(current, next)] += count;
+        }
+    }
+}
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
@@ -0,0 +1,81 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+#pragma once
+
+/** \file
+ * \brief Definitions of the usage_profile class.
+ *
+ * A usage profile counts how many times each character and each kerning
+ * pair gets used. Saved to a file, it lets the next run of the same
+ * service generate the meshes it is going to need in advance.
+ */
+
+// C++
+//
+#include    <cstdint>
+#include    <memory>
+#include    <string>
+#include    <unordered_map>
+#include    <vector>
+
+
+
+namespace ftmesh
+{
+
+
+class usage_profile
+{
+public:
+    typedef std::shared_ptr<usage_profile>  pointer_t;
+
+    struct glyph_count
+    {
+        char32_t            f_glyph = U'\0';
+        std::uint64_t       f_count = 0;
+    };
+    typedef std::vector<glyph_count>        glyph_count_vector_t;
+
+    struct pair_count
+    {
+        char32_t            f_current = U'\0';
+        char32_t            f_next = U'\0';
+        std::uint64_t       f_count = 0;
+    };
+    typedef std::vector<pair_count>         pair_count_vector_t;
+
+    void                    record_glyph(char32_t glyph);
+    void                    record_pair(char32_t current_char, char32_t next_char);
+    void                    clear();
+
+    glyph_count_vector_t    get_glyphs(std::size_t max_count = 0) const;
+    pair_count_vector_t     get_pairs(std::size_t max_count = 0) const;
+
+    void                    save(std::string const & filename, std::size_t max_count = 0) const;
+    void                    load(std::string const & filename);
+
+private:
+    std::unordered_map<char32_t, std::uint64_t>
+                            f_glyphs = std::unordered_map<char32_t, std::uint64_t>();
+    std::unordered_map<std::uint64_t, std::uint64_t>
+                            f_pairs = std::unordered_map<std::uint64_t, std::uint64_t>();
+};
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
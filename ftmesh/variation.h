@@ -0,0 +1,64 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#pragma once
+
+/** \file
+ * \brief Definitions of the variable font structures.
+ *
+ * Variable fonts define one or more axes (i.e. weight, width) along
+ * which the glyphs can be interpolated. Some points along those axes
+ * are given a name (i.e. "Bold") and are called named instances.
+ */
+
+// C++
+//
+#include    <cstdint>
+#include    <string>
+#include    <vector>
+
+
+namespace ftmesh
+{
+
+
+
+struct variation_axis
+{
+    typedef std::vector<variation_axis>     vector_t;
+
+    std::string         f_name = std::string();
+    std::uint32_t       f_tag = 0;
+    double              f_minimum = 0.0;
+    double              f_default = 0.0;
+    double              f_maximum = 0.0;
+};
+
+
+struct named_instance
+{
+    typedef std::vector<named_instance>     vector_t;
+
+    std::string         f_name = std::string();
+    std::vector<double> f_coordinates = std::vector<double>();
+};
+
+
+
+} // namespace ftmesh
+// vim: ts=4 sw=4 et
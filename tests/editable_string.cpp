@@ -0,0 +1,139 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/editable_string.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_reached.h>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+// we're testing many of those here so ignore warnings
+//
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+
+namespace
+{
+
+
+// the editable string must give the same result as converting the text
+//
+void verify_string(ftmesh::font & f, ftmesh::editable_string & s)
+{
+    ftmesh::mesh_string::const_pointer_t expected(f.convert_string(s.get_text()));
+    CATCH_REQUIRE(s.size() == expected->size());
+    float x(0.0f);
+    for(std::size_t idx(0); idx < s.size(); ++idx)
+    {
+        CATCH_REQUIRE(s.get_mesh(idx) == (*expected)[idx]->get_mesh());
+        CATCH_REQUIRE(s.get_advance(idx) == (*expected)[idx]->get_advance());
+        CATCH_REQUIRE(s.get_position(idx) == x);
+        x += s.get_advance(idx);
+    }
+    CATCH_REQUIRE(s.get_width() == x);
+    CATCH_REQUIRE(s.get_width() == expected->get_width());
+}
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("editable_string", "[editable_string]")
+{
+    CATCH_START_SECTION("Edit a string")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::editable_string s(f);
+
+        s.set_text(U"WAVE");
+        verify_string(f, s);
+        float const width(s.get_width());
+        float const v_position(s.get_position(2));
+
+        // "A" then "V" kern, inserting a character in between changes
+        // the advance of the "A" too
+        //
+        ftmesh::editable_string::change c(s.insert(2, U"x"));
+        CATCH_REQUIRE(s.get_text() == U"WAxVE");
+        CATCH_REQUIRE(c.f_first == 1);
+        CATCH_REQUIRE(c.f_erased == 1);
+        CATCH_REQUIRE(c.f_inserted == 2);
+        verify_string(f, s);
+        CATCH_REQUIRE(s.get_position(3) == v_position + c.f_shift);
+        CATCH_REQUIRE(s.get_width() == width + c.f_shift);
+
+        c = s.erase(2, 1);
+        CATCH_REQUIRE(s.get_text() == U"WAVE");
+        CATCH_REQUIRE(c.f_first == 1);
+        CATCH_REQUIRE(c.f_erased == 2);
+        CATCH_REQUIRE(c.f_inserted == 1);
+        verify_string(f, s);
+        CATCH_REQUIRE(s.get_width() == width);
+
+        c = s.replace(0, 1, U"Zo");
+        CATCH_REQUIRE(s.get_text() == U"ZoAVE");
+        CATCH_REQUIRE(c.f_first == 0);
+        CATCH_REQUIRE(c.f_erased == 1);
+        CATCH_REQUIRE(c.f_inserted == 2);
+        verify_string(f, s);
+
+        // count gets clamped
+        //
+        c = s.erase(3, 100);
+        CATCH_REQUIRE(s.get_text() == U"ZoA");
+        CATCH_REQUIRE(c.f_erased == 3);
+        CATCH_REQUIRE(c.f_inserted == 1);
+        verify_string(f, s);
+
+        c = s.insert(3, U" end");
+        CATCH_REQUIRE(s.get_text() == U"ZoA end");
+        verify_string(f, s);
+
+        ftmesh::mesh_string::pointer_t m(s.to_mesh_string());
+        CATCH_REQUIRE(m->size() == s.size());
+        CATCH_REQUIRE(m->get_width() == s.get_width());
+        CATCH_REQUIRE((*m)[2]->get_code_point() == U'A');
+
+        s.set_text(U"");
+        CATCH_REQUIRE(s.size() == 0);
+        CATCH_REQUIRE(s.get_width() == 0.0f);
+
+        CATCH_REQUIRE_THROWS_AS(s.insert(1, U"a"), std::out_of_range);
+        CATCH_REQUIRE_THROWS_AS(s.get_position(1), std::out_of_range);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -32,8 +32,29 @@
 #include    <snapdev/not_reached.h>
 
 
+// FreeType
+//
+#include    <ft2build.h>
+#include    FT_FREETYPE_H
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cmath>
+#include    <cstring>
+#include    <fstream>
+#include    <iterator>
+#include    <limits>
+#include    <map>
+#include    <mutex>
+#include    <sstream>
+
+
 // C
 //
+#include    <fcntl.h>
+#include    <sys/mman.h>
 #include    <unistd.h>
 
 
@@ -42,6 +63,77 @@
 #pragma GCC diagnostic ignored "-Wfloat-equal"
 
 
+
+namespace
+{
+
+
+std::uint32_t read_uint(std::string const & data, std::size_t offset, std::size_t size)
+{
+    std::uint32_t result(0);
+    for(std::size_t idx(0); idx < size; ++idx)
+    {
+        result = (result << 8) | static_cast<unsigned char>(data[offset + idx]);
+    }
+    return result;
+}
+
+
+std::size_t find_table(std::string const & font, char const * tag)
+{
+    std::size_t const table_count(read_uint(font, 4, 2));
+    for(std::size_t idx(0); idx < table_count; ++idx)
+    {
+        std::size_t const entry(12 + idx * 16);
+        if(font.compare(entry, 4, tag) == 0)
+        {
+            return read_uint(font, entry + 8, 4);
+        }
+    }
+    throw std::runtime_error(std::string("table ") + tag + " not found");
+}
+
+
+// create a font where the first component of some composite glyphs is
+// replaced by another glyph (i.e. the composite itself)
+//
+std::string create_hostile_font(
+      std::string const & ttf
+    , std::vector<std::pair<std::uint32_t, std::uint32_t>> const & components)
+{
+    std::ifstream in(ttf, std::ios::binary);
+    std::string font((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::size_t const head(find_table(font, "head"));
+    std::size_t const loca(find_table(font, "loca"));
+    std::size_t const glyf(find_table(font, "glyf"));
+    bool const long_offsets(read_uint(font, head + 50, 2) != 0);
+    for(auto const & c : components)
+    {
+        std::size_t const offset(glyf + (long_offsets
+                    ? read_uint(font, loca + c.first * 4, 4)
+                    : read_uint(font, loca + c.first * 2, 2) * 2));
+
+        // the glyph must be a composite (numberOfContours is -1)
+        //
+        CATCH_REQUIRE(read_uint(font, offset, 2) == 0xFFFF);
+
+        // glyph header (10 bytes) + component flags (2 bytes)
+        //
+        font[offset + 12] = static_cast<char>(c.second >> 8);
+        font[offset + 13] = static_cast<char>(c.second);
+    }
+
+    std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/hostile.ttf");
+    std::ofstream out(filename, std::ios::binary);
+    out.write(font.data(), font.size());
+    return filename;
+}
+
+
+} // no name namespace
+
+
 CATCH_TEST_CASE("font", "[font]")
 {
     CATCH_START_SECTION("Make sure font works")
@@ -49,11 +141,11 @@ CATCH_TEST_CASE("font", "[font]")
         ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf");
         f.set_size(78, 72, 72);
 
-        ftmesh::mesh_string::pointer_t s(f.convert_string("FtMesh ij"));
+        ftmesh::mesh_string::const_pointer_t s(f.convert_string("FtMesh ij"));
         for(auto c : *s)
         {
             ftmesh::mesh::pointer_t m(c->get_mesh());
-            ftmesh::point::vector_t const & p(m->get_points());
+            ftmesh::mesh::point_vector_t const & p(m->get_points());
             ftmesh::mesh::index_vector_t const & i(m->get_indexes());
 //std::cerr << "Mesh advance = " << c->get_advance() << " (" << i.size() << " indexes)\n";
             for(std::size_t j(0); j < i.size(); ++j)
@@ -76,6 +168,1187 @@ std::cerr << "advance by " << advance << " to next glyph\n";
         }
     }
     CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Strips with primitive restart")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf");
+        f.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+
+        ftmesh::mesh::pointer_t m(f.get_mesh(U'O'));
+        CATCH_REQUIRE(m != nullptr);
+        CATCH_REQUIRE(m->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        CATCH_REQUIRE_FALSE(m->get_elements().empty());
+        for(auto const e : m->get_elements())
+        {
+            CATCH_REQUIRE((e == ftmesh::PRIMITIVE_RESTART_INDEX || e < m->get_points().size()));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Simplified glyphs stay within the tolerance")
+    {
+        double const tolerance(1.0);
+
+        ftmesh::font full("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        full.set_size(200, 72, 72);
+        full.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        full.set_simplify_tolerance(0.0);
+
+        ftmesh::font simple("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        simple.set_size(200, 72, 72);
+        simple.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        simple.set_simplify_tolerance(tolerance);
+
+        for(char32_t const c : std::u32string(U"OSg@"))
+        {
+            ftmesh::mesh::pointer_t original(full.get_mesh(c));
+            ftmesh::mesh::pointer_t simplified(simple.get_mesh(c));
+            CATCH_REQUIRE(simplified->get_elements().size() < original->get_elements().size());
+
+            // the contours of the simplified glyph are the triangle edges
+            // which are not shared with another triangle
+            //
+            ftmesh::mesh::element_vector_t const & elements(simplified->get_elements());
+            std::map<std::pair<std::uint32_t, std::uint32_t>, int> edges;
+            for(std::size_t idx(0); idx + 2 < elements.size(); idx += 3)
+            {
+                for(std::size_t k(0); k < 3; ++k)
+                {
+                    ++edges[std::minmax(elements[idx + k], elements[idx + (k + 1) % 3])];
+                }
+            }
+
+            // every point of the original outline is within the tolerance
+            // of the simplified outline
+            //
+            ftmesh::mesh::point_vector_t const & points(simplified->get_points());
+            for(auto const & p : original->get_points())
+            {
+                double distance(std::numeric_limits<double>::max());
+                for(auto const & e : edges)
+                {
+                    if(e.second != 1)
+                    {
+                        continue;
+                    }
+                    ftmesh::point const a(points[e.first.first]);
+                    ftmesh::point const ab(points[e.first.second] - a);
+                    ftmesh::point const ap(p - a);
+                    double const length2(ab.x() * ab.x() + ab.y() * ab.y());
+                    double const t(length2 > 0.0
+                            ? std::clamp((ap.x() * ab.x() + ap.y() * ab.y()) / length2, 0.0, 1.0)
+                            : 0.0);
+                    distance = std::min(distance, std::hypot(ap.x() - ab.x() * t, ap.y() - ab.y() * t));
+                }
+                CATCH_REQUIRE(distance <= tolerance + 0.001);
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("String bounds and width")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf");
+
+        ftmesh::mesh_string::const_pointer_t s(f.convert_string("AV. To"));
+        CATCH_REQUIRE(s->get_width() == f.string_width("AV. To"));
+
+        // verify the union computed on the fly against the vertices
+        //
+        ftmesh::box expected;
+        float x(0.0f);
+        for(auto c : *s)
+        {
+            for(auto const & p : c->get_mesh()->get_points())
+            {
+                expected.add_point(ftmesh::point(p.x() + x, p.y()));
+            }
+            x += c->get_advance();
+        }
+        CATCH_REQUIRE(s->get_bounds().f_min.x() == expected.f_min.x());
+        CATCH_REQUIRE(s->get_bounds().f_min.y() == expected.f_min.y());
+        CATCH_REQUIRE(s->get_bounds().f_max.x() == expected.f_max.x());
+        CATCH_REQUIRE(s->get_bounds().f_max.y() == expected.f_max.y());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Composite glyphs reuse their components")
+    {
+        ftmesh::font regular("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        f.set_reuse_composites(true);
+
+        ftmesh::mesh::pointer_t e(f.get_mesh(U'e'));
+        ftmesh::mesh::pointer_t e_acute(f.get_mesh(U'é'));
+        CATCH_REQUIRE_FALSE(e->is_composite());
+        CATCH_REQUIRE(e_acute->is_composite());
+        CATCH_REQUIRE(e_acute->get_points().empty());
+
+        // the base letter is shared, not tessellated again
+        //
+        bool found(false);
+        for(auto const & c : e_acute->get_components())
+        {
+            found = found || c.f_mesh == e;
+        }
+        CATCH_REQUIRE(found);
+
+        ftmesh::mesh::pointer_t expected(regular.get_mesh(U'é'));
+        ftmesh::mesh::pointer_t flat(e_acute->flatten());
+        CATCH_REQUIRE_FALSE(flat->is_composite());
+        CATCH_REQUIRE(flat->get_points().size() == expected->get_points().size());
+        CATCH_REQUIRE(e_acute->get_advance() == expected->get_advance());
+        CATCH_REQUIRE(SNAP_CATCH2_NAMESPACE::nearly_equal(flat->get_bounds().f_max.y(), expected->get_bounds().f_max.y(), 0.01));
+        CATCH_REQUIRE(SNAP_CATCH2_NAMESPACE::nearly_equal(e_acute->get_bounds().f_max.y(), expected->get_bounds().f_max.y(), 0.01));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Identical outlines share one mesh")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        // Latin, Greek and Cyrillic capital A use the same outline
+        //
+        ftmesh::mesh::pointer_t latin(f.get_mesh(U'A'));
+        CATCH_REQUIRE(latin != nullptr);
+        CATCH_REQUIRE(f.get_mesh(U'\u0391') == latin);
+        CATCH_REQUIRE(f.get_mesh(U'\u0410') == latin);
+
+        // missing characters all use glyph 0
+        //
+        CATCH_REQUIRE(f.get_mesh(U'\uE000') == f.get_mesh(U'\uE001'));
+
+        CATCH_REQUIRE(f.get_mesh(U'B') != latin);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Glyph instances share one pool")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        f.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+
+        ftmesh::glyph_pool::instance_vector_t const instances(f.convert_instances("abc abc"));
+        ftmesh::glyph_pool::pointer_t pool(f.get_glyph_pool());
+
+        // the space has no geometry, it only advances the position
+        //
+        CATCH_REQUIRE(instances.size() == 6);
+        CATCH_REQUIRE(pool->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        CATCH_REQUIRE(instances[0].f_range == instances[3].f_range);
+        CATCH_REQUIRE(instances[1].f_range == instances[4].f_range);
+        CATCH_REQUIRE(instances[0].f_x == 0.0f);
+        CATCH_REQUIRE(instances[3].f_x == f.string_width("abc "));
+
+        // the ranges are packed back to back
+        //
+        std::uint32_t vertices(0);
+        std::uint32_t elements(0);
+        for(auto const & r : pool->get_ranges())
+        {
+            CATCH_REQUIRE(r.f_first_vertex == vertices);
+            CATCH_REQUIRE(r.f_first_element == elements);
+            vertices += r.f_vertex_count;
+            elements += r.f_element_count;
+        }
+        CATCH_REQUIRE(pool->get_vertices().size() == vertices * 2);
+        CATCH_REQUIRE(pool->get_elements().size() == elements);
+
+        // converting again does not grow the pool
+        //
+        f.convert_instances("cab");
+        CATCH_REQUIRE(pool->get_elements().size() == elements);
+
+        // changing the format starts a new pool, the meshes cached with
+        // the previous format get converted
+        //
+        f.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        ftmesh::glyph_pool::instance_vector_t const strips(f.convert_instances("abcx"));
+        ftmesh::glyph_pool::pointer_t strip_pool(f.get_glyph_pool());
+        CATCH_REQUIRE(strip_pool != pool);
+        CATCH_REQUIRE(strip_pool->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        CATCH_REQUIRE(strips.size() == 4);
+        CATCH_REQUIRE(pool->get_elements().size() == elements);
+        for(auto const & r : strip_pool->get_ranges())
+        {
+            CATCH_REQUIRE(r.f_element_count > 0);
+            for(std::uint32_t idx(0); idx < r.f_element_count; ++idx)
+            {
+                std::uint32_t const e(strip_pool->get_elements()[r.f_first_element + idx]);
+                CATCH_REQUIRE((e == ftmesh::PRIMITIVE_RESTART_INDEX || e < r.f_vertex_count));
+            }
+        }
+        CATCH_REQUIRE(f.get_glyph_pool() == strip_pool);
+
+        // the pool does not keep its meshes alive
+        //
+        ftmesh::glyph_pool own_pool;
+        std::weak_ptr<ftmesh::mesh> weak;
+        {
+            ftmesh::mesh::pointer_t m(std::make_shared<ftmesh::mesh>(1.0f));
+            m->begin();
+            m->add_point(ftmesh::point(0.0, 0.0));
+            m->add_point(ftmesh::point(1.0, 0.0));
+            m->add_point(ftmesh::point(0.0, 1.0));
+            m->end();
+            weak = m;
+            CATCH_REQUIRE(own_pool.add_mesh(m) == 0);
+            CATCH_REQUIRE(own_pool.add_mesh(m) == 0);
+        }
+        CATCH_REQUIRE(weak.expired());
+        CATCH_REQUIRE(own_pool.get_elements().size() == 3);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Meshes allocated in a slab")
+    {
+        ftmesh::font regular("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::mesh::pointer_t expected(regular.get_mesh(U'g'));
+
+        ftmesh::mesh::pointer_t m;
+        {
+            ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+            f.set_slab_storage(true);
+            m = f.get_mesh(U'g');
+        }
+
+        // the mesh keeps the slab alive after the font is gone
+        //
+        CATCH_REQUIRE(m->get_points().size() == expected->get_points().size());
+        for(std::size_t idx(0); idx < m->get_points().size(); ++idx)
+        {
+            CATCH_REQUIRE(m->get_points()[idx].x() == expected->get_points()[idx].x());
+            CATCH_REQUIRE(m->get_points()[idx].y() == expected->get_points()[idx].y());
+        }
+        CATCH_REQUIRE(m->get_indexes().size() == expected->get_indexes().size());
+        CATCH_REQUIRE(m->get_advance() == expected->get_advance());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("UTF-8 and UTF-32 inputs give the same result")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        std::string const utf8("Vé Ωmega AV");
+        std::u32string const utf32(U"Vé Ωmega AV");
+
+        ftmesh::mesh_string::const_pointer_t a(f.convert_string(utf8));
+        ftmesh::mesh_string::const_pointer_t b(f.convert_string(utf32));
+        CATCH_REQUIRE(a->size() == utf32.length());
+        CATCH_REQUIRE(a->size() == b->size());
+        for(std::size_t idx(0); idx < a->size(); ++idx)
+        {
+            CATCH_REQUIRE((*a)[idx]->get_mesh() == (*b)[idx]->get_mesh());
+            CATCH_REQUIRE((*a)[idx]->get_advance() == (*b)[idx]->get_advance());
+        }
+        CATCH_REQUIRE(f.string_width(utf8) == f.string_width(utf32));
+        CATCH_REQUIRE(f.string_width(std::string_view(utf8).substr(0, 3)) == f.string_width(U"Vé"));
+
+        CATCH_REQUIRE(f.convert_string("")->empty());
+        CATCH_REQUIRE(f.string_width(U"") == 0.0f);
+
+        CATCH_REQUIRE_THROWS(f.convert_string("bad \xFF utf-8"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Stream conversion in batches")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        std::string const text("Vé AV\nAVé");
+        ftmesh::mesh_string::const_pointer_t line1(f.convert_string(U"Vé AV"));
+        ftmesh::mesh_string::const_pointer_t line2(f.convert_string(U"AVé"));
+
+        // feed one byte at a time so the 'é' gets split
+        //
+        std::size_t pos(0);
+        std::vector<std::size_t> batch_sizes;
+        ftmesh::positioned_glyph::vector_t glyphs;
+        f.convert_stream(
+              [&text, &pos](std::string & chunk)
+              {
+                  if(pos >= text.length())
+                  {
+                      return false;
+                  }
+                  chunk = text.substr(pos, 1);
+                  ++pos;
+                  return true;
+              }
+            , [&batch_sizes, &glyphs](ftmesh::positioned_glyph::vector_t const & batch)
+              {
+                  batch_sizes.push_back(batch.size());
+                  glyphs.insert(glyphs.end(), batch.begin(), batch.end());
+                  return true;
+              }
+            , 2);
+
+        CATCH_REQUIRE(glyphs.size() == line1->size() + line2->size());
+        CATCH_REQUIRE(batch_sizes == std::vector<std::size_t>({ 2, 2, 2, 2 }));
+
+        float x(0.0f);
+        for(std::size_t idx(0); idx < line1->size(); ++idx)
+        {
+            CATCH_REQUIRE(glyphs[idx].f_mesh == (*line1)[idx]->get_mesh());
+            CATCH_REQUIRE(glyphs[idx].f_x == x);
+            CATCH_REQUIRE(glyphs[idx].f_y == 0.0f);
+            x += (*line1)[idx]->get_advance();
+        }
+        x = 0.0f;
+        for(std::size_t idx(0); idx < line2->size(); ++idx)
+        {
+            ftmesh::positioned_glyph const & g(glyphs[line1->size() + idx]);
+            CATCH_REQUIRE(g.f_mesh == (*line2)[idx]->get_mesh());
+            CATCH_REQUIRE(g.f_x == x);
+            CATCH_REQUIRE(g.f_y == -f.get_line_height());
+            x += (*line2)[idx]->get_advance();
+        }
+        CATCH_REQUIRE(glyphs.back().f_code_point == U'é');
+
+        // the istream version gives the same glyphs, stop after the first batch
+        //
+        std::istringstream in(text);
+        std::size_t count(0);
+        f.convert_stream(
+              in
+            , [&count, &glyphs](ftmesh::positioned_glyph::vector_t const & batch)
+              {
+                  for(auto const & g : batch)
+                  {
+                      CATCH_REQUIRE(g.f_mesh == glyphs[count].f_mesh);
+                      CATCH_REQUIRE(g.f_x == glyphs[count].f_x);
+                      ++count;
+                  }
+                  return false;
+              }
+            , 3);
+        CATCH_REQUIRE(count == 3);
+
+        std::istringstream bad("abc\xC3");
+        CATCH_REQUIRE_THROWS(f.convert_stream(
+              bad
+            , [](ftmesh::positioned_glyph::vector_t const &) { return true; }));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Caret, hit test and truncation")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        ftmesh::mesh_string::const_pointer_t s(f.convert_string(U"AVery long label"));
+        CATCH_REQUIRE((*s)[0]->get_code_point() == U'A');
+        CATCH_REQUIRE((*s)[1]->get_code_point() == U'V');
+
+        float x(0.0f);
+        for(std::size_t idx(0); idx < s->size(); ++idx)
+        {
+            CATCH_REQUIRE(s->get_caret_position(idx) == x);
+            CATCH_REQUIRE(s->hit_test(x) == idx);
+            CATCH_REQUIRE(s->hit_test(x + (*s)[idx]->get_advance() / 2.0f) == idx);
+            CATCH_REQUIRE(s->fit_width(x) == idx);
+            x += (*s)[idx]->get_advance();
+        }
+        CATCH_REQUIRE(s->get_caret_position(s->size()) == s->get_width());
+        CATCH_REQUIRE_THROWS(s->get_caret_position(s->size() + 1));
+        CATCH_REQUIRE(s->hit_test(-5.0f) == 0);
+        CATCH_REQUIRE(s->hit_test(s->get_width() + 5.0f) == s->size());
+        CATCH_REQUIRE(s->fit_width(s->get_width()) == s->size());
+
+        // a string which fits is not modified
+        //
+        ftmesh::mesh_string::pointer_t t(f.truncate_string(U"AVery long label", s->get_width()));
+        CATCH_REQUIRE(t->size() == s->size());
+        CATCH_REQUIRE(t->get_width() == s->get_width());
+
+        float const max_width(s->get_width() / 2.0f);
+        t = f.truncate_string("AVery long label", max_width);
+        CATCH_REQUIRE(t->size() > 1);
+        CATCH_REQUIRE(t->size() < s->size());
+        CATCH_REQUIRE(t->get_width() <= max_width);
+        CATCH_REQUIRE(t->back()->get_code_point() == U'…');
+        for(std::size_t idx(0); idx + 2 < t->size(); ++idx)
+        {
+            CATCH_REQUIRE((*t)[idx]->get_mesh() == (*s)[idx]->get_mesh());
+            CATCH_REQUIRE((*t)[idx]->get_advance() == (*s)[idx]->get_advance());
+        }
+
+        // one more character would not fit
+        //
+        std::u32string longer;
+        for(std::size_t idx(0); idx < t->size(); ++idx)
+        {
+            longer += (*s)[idx]->get_code_point();
+        }
+        longer += U'…';
+        CATCH_REQUIRE(f.string_width(longer) > max_width);
+
+        t = f.truncate_string(U"AVery long label", 0.0f, U'.');
+        CATCH_REQUIRE(t->size() == 1);
+        CATCH_REQUIRE(t->back()->get_code_point() == U'.');
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("String cache")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        // disabled by default
+        //
+        ftmesh::mesh_string::const_pointer_t a(f.convert_string("OK"));
+        CATCH_REQUIRE(f.convert_string("OK") != a);
+        CATCH_REQUIRE(f.get_string_cache_usage() == 0);
+
+        f.set_string_cache_size(10 * 1024);
+        a = f.convert_string("OK");
+        CATCH_REQUIRE(f.get_string_cache_usage() > 0);
+        CATCH_REQUIRE(f.convert_string("OK") == a);
+        CATCH_REQUIRE(f.convert_string(U"OK") == a);
+        CATCH_REQUIRE(f.string_width("OK") == a->get_width());
+
+        // UTF-32 strings are encoded in the key so both inputs find the
+        // same entries, including multibyte characters
+        //
+        ftmesh::mesh_string::const_pointer_t greek(f.convert_string(U"Ωmega 😀"));
+        CATCH_REQUIRE(f.convert_string("Ωmega 😀") == greek);
+        CATCH_REQUIRE(f.string_width(U"Ωmega 😀") == greek->get_width());
+        CATCH_REQUIRE(greek->size() == 7);
+
+        // a width only entry gets upgraded by convert_string()
+        //
+        float const width(f.string_width(U"Cancel"));
+        std::size_t const usage(f.get_string_cache_usage());
+        CATCH_REQUIRE(f.string_width("Cancel") == width);
+        CATCH_REQUIRE(f.get_string_cache_usage() == usage);
+        ftmesh::mesh_string::const_pointer_t b(f.convert_string("Cancel"));
+        CATCH_REQUIRE(b->get_width() == width);
+        CATCH_REQUIRE(f.get_string_cache_usage() > usage);
+        CATCH_REQUIRE(f.convert_string("Cancel") == b);
+
+        // the settings are part of the key
+        //
+        f.set_size(24, 72, 72);
+        CATCH_REQUIRE(f.convert_string("OK") != a);
+
+        // the memory is bounded, the least recently used strings go first
+        //
+        for(int idx(0); idx < 1000; ++idx)
+        {
+            f.convert_string(std::to_string(idx));
+            CATCH_REQUIRE(f.get_string_cache_usage() <= 10 * 1024);
+        }
+        ftmesh::mesh_string::const_pointer_t last(f.convert_string("999"));
+        CATCH_REQUIRE(f.convert_string("999") == last);
+        ftmesh::mesh_string::const_pointer_t first(f.convert_string("0"));
+        CATCH_REQUIRE(f.convert_string("0") == first);
+
+        f.clear_string_cache();
+        CATCH_REQUIRE(f.get_string_cache_usage() == 0);
+        CATCH_REQUIRE(f.convert_string("0") != first);
+
+        f.set_string_cache_size(0);
+        CATCH_REQUIRE(f.get_string_cache_usage() == 0);
+        CATCH_REQUIRE(f.convert_string("0") != f.convert_string("0"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Meshes generated in the background")
+    {
+        // the callback may still run until the font gets destroyed so
+        // these variables are defined first
+        //
+        std::mutex ready_mutex;
+        std::u32string ready;
+
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        f.set_mesh_ready_callback([&ready_mutex, &ready](char32_t glyph, ftmesh::mesh::pointer_t m)
+            {
+                // catch is not thread safe, only record the result here
+                //
+                std::lock_guard<std::mutex> lock(ready_mutex);
+                if(m != nullptr)
+                {
+                    ready += glyph;
+                }
+            });
+
+        std::shared_future<ftmesh::mesh::pointer_t> a(f.get_mesh_async(U'a'));
+        std::shared_future<ftmesh::mesh::pointer_t> same(f.get_mesh_async(U'a'));
+        ftmesh::mesh::pointer_t m(a.get());
+        CATCH_REQUIRE(m != nullptr);
+        CATCH_REQUIRE(!m->is_placeholder());
+        CATCH_REQUIRE(same.get() == m);
+        CATCH_REQUIRE(f.get_mesh(U'a') == m);
+        CATCH_REQUIRE(f.get_mesh_async(U'a').get() == m);
+
+        // with placeholders, the string is available right away with the
+        // final advances
+        //
+        ftmesh::font expected_font("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::mesh_string::const_pointer_t expected(expected_font.convert_string(U"Qwerty 42"));
+
+        f.set_placeholders(true);
+        ftmesh::mesh_string::const_pointer_t s(f.convert_string(U"Qwerty 42"));
+        CATCH_REQUIRE(s->size() == expected->size());
+        CATCH_REQUIRE(s->get_width() == expected->get_width());
+        for(std::size_t idx(0); idx < s->size(); ++idx)
+        {
+            ftmesh::mesh::pointer_t const & p((*s)[idx]->get_mesh());
+            if(p->is_placeholder())
+            {
+                // two triangles or nothing (space)
+                //
+                CATCH_REQUIRE((p->get_points().empty() || p->get_points().size() == 6));
+                CATCH_REQUIRE(p->get_bearing_x() == (*expected)[idx]->get_mesh()->get_bearing_x());
+            }
+            CATCH_REQUIRE(p->get_advance() == (*expected)[idx]->get_mesh()->get_advance());
+
+            // wait for the real mesh
+            //
+            ftmesh::mesh::pointer_t final_mesh(f.get_mesh_async((*s)[idx]->get_code_point()).get());
+            CATCH_REQUIRE(!final_mesh->is_placeholder());
+            CATCH_REQUIRE(final_mesh->get_elements().size() == (*expected)[idx]->get_mesh()->get_elements().size());
+        }
+
+        // now all the meshes are ready
+        //
+        s = f.convert_string(U"Qwerty 42");
+        for(std::size_t idx(0); idx < s->size(); ++idx)
+        {
+            CATCH_REQUIRE(!(*s)[idx]->get_mesh()->is_placeholder());
+        }
+
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        CATCH_REQUIRE(ready.find(U'a') != std::u32string::npos);
+        CATCH_REQUIRE(ready.find(U'Q') != std::u32string::npos);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Destroying a font settles the pending futures")
+    {
+        std::vector<std::shared_future<ftmesh::mesh::pointer_t>> pending;
+        {
+            ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+            for(char32_t c(U'\u0400'); c < U'\u0500'; ++c)
+            {
+                pending.push_back(f.get_mesh_async(c));
+            }
+        }
+
+        // a broken promise would throw a std::future_error instead
+        //
+        std::size_t destroyed(0);
+        for(auto const & p : pending)
+        {
+            try
+            {
+                p.get();
+            }
+            catch(std::runtime_error const &)
+            {
+                ++destroyed;
+            }
+        }
+        CATCH_REQUIRE(destroyed > 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Meshes shared through shared memory")
+    {
+        std::string const name("/ftmesh-test-" + std::to_string(getpid()));
+        shm_unlink(name.c_str());
+
+        ftmesh::font a("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        a.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        a.set_shared_cache(name, 1024 * 1024);
+        ftmesh::mesh::pointer_t ma(a.get_mesh(U'g'));
+        ftmesh::mesh::pointer_t composite(a.get_mesh(U'é'));
+
+        // the second font finds the meshes in the segment
+        //
+        ftmesh::font b("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        b.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        b.set_shared_cache(name, 1024 * 1024);
+        for(auto const & expected : { ma, composite })
+        {
+            ftmesh::mesh::pointer_t m(b.get_mesh(expected == ma ? U'g' : U'é'));
+            CATCH_REQUIRE(m != expected);
+            CATCH_REQUIRE(m->get_format() == expected->get_format());
+            CATCH_REQUIRE(m->get_advance() == expected->get_advance());
+            CATCH_REQUIRE(m->get_bearing_x() == expected->get_bearing_x());
+            CATCH_REQUIRE(m->get_bearing_y() == expected->get_bearing_y());
+            CATCH_REQUIRE(m->get_points().size() == expected->get_points().size());
+            for(std::size_t idx(0); idx < m->get_points().size(); ++idx)
+            {
+                CATCH_REQUIRE(m->get_points()[idx].x() == expected->get_points()[idx].x());
+                CATCH_REQUIRE(m->get_points()[idx].y() == expected->get_points()[idx].y());
+            }
+            CATCH_REQUIRE(std::equal(
+                      m->get_elements().begin()
+                    , m->get_elements().end()
+                    , expected->get_elements().begin()
+                    , expected->get_elements().end()));
+            CATCH_REQUIRE(m->get_bounds().width() == expected->get_bounds().width());
+        }
+
+        // a different size is a different key
+        //
+        ftmesh::font c("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        c.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        c.set_size(24, 72, 72);
+        c.set_shared_cache(name, 1024 * 1024);
+        CATCH_REQUIRE(c.get_mesh(U'g')->get_advance() != ma->get_advance());
+
+        // the size of an existing segment must match
+        //
+        ftmesh::font d("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        CATCH_REQUIRE_THROWS_AS(d.set_shared_cache(name, 2 * 1024 * 1024), std::runtime_error);
+
+        shm_unlink(name.c_str());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Fonts sharing a face keep their own size")
+    {
+        ftmesh::font::set_max_idle_faces(2);
+
+        ftmesh::font small("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::font large("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        large.set_size(24, 72, 72);
+
+        float const small_width(small.string_width(U"Shared face"));
+        float const large_width(large.string_width(U"Shared face"));
+        CATCH_REQUIRE(large_width > small_width * 1.9f);
+        CATCH_REQUIRE(small.get_line_height() < large.get_line_height());
+
+        // interleave the calls to make sure each font activates its size
+        //
+        for(char32_t c(U'a'); c <= U'z'; ++c)
+        {
+            CATCH_REQUIRE(large.get_mesh(c)->get_advance() > small.get_mesh(c)->get_advance());
+            CATCH_REQUIRE(small.get_kerning(U'A', c) == small.get_kerning(U'A', c));
+        }
+        CATCH_REQUIRE(small.string_width(U"Shared face") == small_width);
+
+        {
+            // a font destroyed and opened again reuses the idle face
+            //
+            ftmesh::font temporary("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf");
+            temporary.get_mesh(U'x');
+        }
+        ftmesh::font again("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf");
+        CATCH_REQUIRE(again.get_mesh(U'x') != nullptr);
+
+        ftmesh::font::close_idle_faces();
+        ftmesh::font::set_max_idle_faces(16);
+
+        CATCH_REQUIRE_THROWS_AS(ftmesh::font("/this/font/does/not/exist.ttf"), std::runtime_error);
+        CATCH_REQUIRE_THROWS_WITH(
+                  ftmesh::font("/this/font/does/not/exist.ttf")
+                , "open() could not open font file \"/this/font/does/not/exist.ttf\".");
+
+        std::string const empty("/tmp/ftmesh-empty-" + std::to_string(getpid()) + ".ttf");
+        std::ofstream(empty).close();
+        CATCH_REQUIRE_THROWS_WITH(
+                  ftmesh::font(empty)
+                , "font file \"" + empty + "\" is empty.");
+        unlink(empty.c_str());
+
+        std::string const garbage("/tmp/ftmesh-garbage-" + std::to_string(getpid()) + ".ttf");
+        std::ofstream(garbage) << "this is not a font";
+        CATCH_REQUIRE_THROWS_WITH(
+                  ftmesh::font(garbage)
+                , Catch::Matchers::StartsWith("FT_New_Memory_Face() could not load \"" + garbage + "\" (FT_Error: "));
+        unlink(garbage.c_str());
+
+        // a symbolic link shares the mapping of its target
+        //
+        std::string const link("/tmp/ftmesh-link-" + std::to_string(getpid()) + ".ttf");
+        unlink(link.c_str());
+        CATCH_REQUIRE(symlink("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf", link.c_str()) == 0);
+        {
+            ftmesh::font linked(link);
+            CATCH_REQUIRE(linked.get_mesh(U'x')->get_advance() == again.get_mesh(U'x')->get_advance());
+        }
+        unlink(link.c_str());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Lazy and prefetched fonts")
+    {
+        ftmesh::font immediate("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        immediate.set_precision(32);
+        immediate.set_size(18, 96, 96);
+        CATCH_REQUIRE(immediate.is_open());
+
+        // the settings of a lazy font get applied once it opens
+        //
+        ftmesh::font lazy("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", ftmesh::open_mode_t::OPEN_MODE_LAZY);
+        lazy.set_precision(32);
+        lazy.set_size(18, 96, 96);
+        lazy.set_mesh_format(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLES);
+        CATCH_REQUIRE_FALSE(lazy.is_open());
+        CATCH_REQUIRE(lazy.string_width(U"Lazy font") == immediate.string_width(U"Lazy font"));
+        CATCH_REQUIRE(lazy.is_open());
+        CATCH_REQUIRE(lazy.get_line_height() == immediate.get_line_height());
+
+        ftmesh::font prefetch("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", ftmesh::open_mode_t::OPEN_MODE_PREFETCH);
+        prefetch.set_precision(32);
+        prefetch.set_size(18, 96, 96);
+        CATCH_REQUIRE(prefetch.get_mesh(U'p')->get_advance() == immediate.get_mesh(U'p')->get_advance());
+        CATCH_REQUIRE(prefetch.is_open());
+
+        // errors are raised on first use
+        //
+        ftmesh::font missing("/this/font/does/not/exist.ttf", ftmesh::open_mode_t::OPEN_MODE_LAZY);
+        CATCH_REQUIRE_FALSE(missing.is_open());
+        CATCH_REQUIRE_THROWS_AS(missing.get_mesh(U'a'), std::runtime_error);
+        CATCH_REQUIRE_THROWS_AS(missing.get_line_height(), std::runtime_error);
+        CATCH_REQUIRE_FALSE(missing.is_open());
+
+        ftmesh::font missing_prefetch("/this/font/does/not/exist.ttf", ftmesh::open_mode_t::OPEN_MODE_PREFETCH);
+        CATCH_REQUIRE_THROWS_AS(missing_prefetch.get_mesh(U'a'), std::runtime_error);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Variations of a font which is not a variable font")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        CATCH_REQUIRE(f.get_variation_axes().empty());
+        CATCH_REQUIRE(f.get_named_instances().empty());
+        CATCH_REQUIRE(f.get_variation().empty());
+
+        ftmesh::mesh::pointer_t m(f.get_mesh(U'W'));
+        f.set_variation(std::vector<double>());
+        CATCH_REQUIRE(f.get_mesh(U'W') == m);
+
+        CATCH_REQUIRE_THROWS_AS(f.set_variation(std::vector<double>{ 700.0 }), std::logic_error);
+        CATCH_REQUIRE_THROWS_AS(f.set_variation_step(-1.0), std::runtime_error);
+        f.set_variation_step(0.0);
+        f.set_snap_to_named_instances(true);
+        f.set_variation(std::vector<double>());
+        CATCH_REQUIRE(f.get_mesh(U'W') == m);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Variations of a variable font")
+    {
+        std::string const filename(FTMESH_TEST_FONTS_DIR "/variable.ttf");
+        ftmesh::font f(filename);
+
+        ftmesh::variation_axis::vector_t const axes(f.get_variation_axes());
+        CATCH_REQUIRE(axes.size() == 1);
+        CATCH_REQUIRE(axes[0].f_tag == 0x77676874);     // 'wght'
+        CATCH_REQUIRE(axes[0].f_minimum == 100.0);
+        CATCH_REQUIRE(axes[0].f_default == 400.0);
+        CATCH_REQUIRE(axes[0].f_maximum == 900.0);
+        ftmesh::named_instance::vector_t const instances(f.get_named_instances());
+        CATCH_REQUIRE(instances.size() == 3);
+        CATCH_REQUIRE(instances[2].f_coordinates == std::vector<double>{ 700.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 400.0 });
+
+        // each set of coordinates has its own meshes; the "A" gets wider
+        // with the weight
+        //
+        ftmesh::mesh::pointer_t const regular(f.get_mesh(U'A'));
+        f.set_variation(std::vector<double>{ 900.0 });
+        ftmesh::mesh::pointer_t const black(f.get_mesh(U'A'));
+        CATCH_REQUIRE(black != regular);
+        CATCH_REQUIRE(black->get_advance() > regular->get_advance());
+        CATCH_REQUIRE(black->get_bounds().width() > regular->get_bounds().width());
+        f.set_variation(std::vector<double>{ 400.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == regular);
+        f.set_variation(std::vector<double>());
+        CATCH_REQUIRE(f.get_mesh(U'A') == regular);
+        f.set_variation(std::vector<double>{ 900.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == black);
+
+        // out of range coordinates get clamped
+        //
+        f.set_variation(std::vector<double>{ 2000.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 900.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == black);
+        CATCH_REQUIRE_THROWS_AS(f.set_variation(std::vector<double>{ 400.0, 400.0 }), std::out_of_range);
+
+        // the coordinates are rounded to a multiple of the step
+        //
+        f.set_variation(std::vector<double>{ 700.4 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 700.0 });
+        ftmesh::mesh::pointer_t const bold(f.get_mesh(U'A'));
+        f.set_variation(std::vector<double>{ 699.6 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == bold);
+        f.set_variation_step(50.0);
+        f.set_variation(std::vector<double>{ 730.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 750.0 });
+        f.set_variation(std::vector<double>{ 710.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == bold);
+        f.set_variation_step(0.0);
+        f.set_variation(std::vector<double>{ 733.25 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 733.25 });
+
+        // or snapped to the nearest named instance
+        //
+        f.set_snap_to_named_instances(true);
+        f.set_variation(std::vector<double>{ 600.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 700.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == bold);
+        f.set_variation(std::vector<double>{ 320.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 300.0 });
+        f.set_variation(std::vector<double>{ 420.0 });
+        CATCH_REQUIRE(f.get_variation() == std::vector<double>{ 400.0 });
+        CATCH_REQUIRE(f.get_mesh(U'A') == regular);
+        f.set_snap_to_named_instances(false);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Fonts sharing a variable face keep their own coordinates")
+    {
+        std::string const filename(FTMESH_TEST_FONTS_DIR "/variable.ttf");
+        ftmesh::font regular(filename);
+        ftmesh::font black(filename);
+        black.set_variation(std::vector<double>{ 900.0 });
+
+        // the face is shared so each font applies its own coordinates
+        // before loading a glyph
+        //
+        for(char32_t const c : { U'V', U'A' })
+        {
+            ftmesh::mesh::pointer_t const r(regular.get_mesh(c));
+            ftmesh::mesh::pointer_t const b(black.get_mesh(c));
+            CATCH_REQUIRE(b->get_advance() > r->get_advance());
+            CATCH_REQUIRE(regular.string_width(U"AV") == r->get_advance() * 2.0f);
+            CATCH_REQUIRE(black.string_width(U"AV") == b->get_advance() * 2.0f);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("The number of variant caches is bounded")
+    {
+        ftmesh::font f(FTMESH_TEST_FONTS_DIR "/variable.ttf");
+        f.set_variation_step(0.0);
+        f.set_slab_storage(true);
+        std::weak_ptr<ftmesh::mesh> regular(f.get_mesh(U'A'));
+
+        // each variant allocates its meshes in its own slab so evicting
+        // the variant releases that memory
+        //
+        std::pmr::memory_resource * const regular_slab(f.get_mesh(U'A')->get_points().get_allocator().resource());
+        CATCH_REQUIRE(f.get_mesh(U'V')->get_points().get_allocator().resource() == regular_slab);
+        CATCH_REQUIRE(dynamic_cast<ftmesh::slab *>(regular_slab) != nullptr);
+
+        // the variants used recently are kept
+        //
+        for(std::size_t idx(1); idx < ftmesh::MAX_VARIANT_CACHES; ++idx)
+        {
+            f.set_variation(std::vector<double>{ 400.0 + static_cast<double>(idx) });
+            CATCH_REQUIRE(f.get_mesh(U'A') != regular.lock());
+            CATCH_REQUIRE(f.get_mesh(U'A')->get_points().get_allocator().resource() != regular_slab);
+        }
+        f.set_variation(std::vector<double>());
+        CATCH_REQUIRE(f.get_mesh(U'A') == regular.lock());
+
+        // animating the weight with a step of 0 drops the least recently
+        // used variants, and their meshes, instead of keeping one per frame
+        //
+        for(std::size_t idx(0); idx < ftmesh::MAX_VARIANT_CACHES * 4; ++idx)
+        {
+            f.set_variation(std::vector<double>{ 500.0 + static_cast<double>(idx) / 4.0 });
+            CATCH_REQUIRE(f.get_mesh(U'A') != nullptr);
+            CATCH_REQUIRE(f.shape("AV").size() == 2);
+        }
+        CATCH_REQUIRE(regular.expired());
+        f.set_variation(std::vector<double>());
+        CATCH_REQUIRE(f.get_mesh(U'A') != nullptr);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Synthetic bold and oblique")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::mesh::pointer_t regular(f.get_mesh(U'l'));
+        float const regular_width(f.string_width(U"Synthetic"));
+
+        f.set_synthetic_bold(ftmesh::DEFAULT_SYNTHETIC_BOLD);
+        ftmesh::mesh::pointer_t bold(f.get_mesh(U'l'));
+        CATCH_REQUIRE(bold != regular);
+        CATCH_REQUIRE(bold->get_advance() > regular->get_advance());
+        CATCH_REQUIRE(bold->get_bounds().width()
+                    > regular->get_bounds().width());
+        CATCH_REQUIRE(f.string_width(U"Synthetic") > regular_width);
+
+        // each style keeps its own meshes
+        //
+        f.set_synthetic_bold(0.0);
+        CATCH_REQUIRE(f.get_mesh(U'l') == regular);
+        CATCH_REQUIRE(f.string_width(U"Synthetic") == regular_width);
+        f.set_synthetic_bold(ftmesh::DEFAULT_SYNTHETIC_BOLD);
+        CATCH_REQUIRE(f.get_mesh(U'l') == bold);
+        f.set_synthetic_bold(0.0);
+
+        // the 'l' is a vertical bar, once slanted its top moves right
+        //
+        f.set_synthetic_oblique(ftmesh::DEFAULT_SYNTHETIC_OBLIQUE);
+        ftmesh::mesh::pointer_t oblique(f.get_mesh(U'l'));
+        CATCH_REQUIRE(oblique != regular);
+        CATCH_REQUIRE(oblique->get_advance() == regular->get_advance());
+        CATCH_REQUIRE(oblique->get_bounds().f_max.x() > regular->get_bounds().f_max.x() + 1.0);
+        f.set_synthetic_oblique(0.0);
+        CATCH_REQUIRE(f.get_mesh(U'l') == regular);
+
+        CATCH_REQUIRE_THROWS_AS(f.set_synthetic_bold(-0.1), std::runtime_error);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Load flags")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        CATCH_REQUIRE(f.get_load_flags() == ftmesh::LOAD_FLAG_DEFAULT);
+        ftmesh::mesh::pointer_t hinted(f.get_mesh(U'g'));
+
+        f.set_load_flags(ftmesh::LOAD_FLAG_NO_HINTING | ftmesh::LOAD_FLAG_NO_BITMAP);
+        CATCH_REQUIRE(f.get_load_flags() == (ftmesh::LOAD_FLAG_NO_HINTING | ftmesh::LOAD_FLAG_NO_BITMAP));
+        ftmesh::mesh::pointer_t unhinted(f.get_mesh(U'g'));
+        CATCH_REQUIRE(unhinted != nullptr);
+        CATCH_REQUIRE(unhinted != hinted);
+        CATCH_REQUIRE_FALSE(unhinted->get_points().empty());
+
+        // unhinted meshes scale with the size
+        //
+        {
+            ftmesh::font large("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+            large.set_size(ftmesh::DEFAULT_SIZE * 2, ftmesh::DEFAULT_RESOLUTION, ftmesh::DEFAULT_RESOLUTION);
+            large.set_load_flags(ftmesh::LOAD_FLAG_NO_HINTING);
+            ftmesh::mesh::pointer_t m(large.get_mesh(U'g'));
+            CATCH_REQUIRE(std::fabs(m->get_advance() - unhinted->get_advance() * 2.0f) < 0.05f);
+            CATCH_REQUIRE(std::fabs(m->get_bounds().height() - unhinted->get_bounds().height() * 2.0) < 0.1);
+        }
+
+        f.set_load_flags(ftmesh::LOAD_FLAG_TARGET_LIGHT);
+        CATCH_REQUIRE(f.get_mesh(U'g') != nullptr);
+
+        // each set of flags keeps its own meshes
+        //
+        f.set_load_flags(ftmesh::LOAD_FLAG_DEFAULT);
+        CATCH_REQUIRE(f.get_mesh(U'g') == hinted);
+
+        CATCH_REQUIRE_THROWS_AS(f.set_load_flags(0x0100), std::runtime_error);
+        CATCH_REQUIRE(f.get_load_flags() == ftmesh::LOAD_FLAG_DEFAULT);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Glyph index API")
+    {
+        char const * filename("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        FT_Library library(nullptr);
+        CATCH_REQUIRE(FT_Init_FreeType(&library) == FT_Err_Ok);
+        FT_Face face(nullptr);
+        CATCH_REQUIRE(FT_New_Face(library, filename, 0, &face) == FT_Err_Ok);
+        std::uint32_t const a(FT_Get_Char_Index(face, U'A'));
+        std::uint32_t const v(FT_Get_Char_Index(face, U'V'));
+        std::uint32_t const count(face->num_glyphs);
+        FT_Done_Face(face);
+        FT_Done_FreeType(library);
+        CATCH_REQUIRE(a != 0);
+        CATCH_REQUIRE(v != 0);
+
+        ftmesh::font f(filename);
+
+        // the index and code point APIs share their meshes
+        //
+        ftmesh::mesh::pointer_t ma(f.get_mesh_by_index(a));
+        CATCH_REQUIRE(ma != nullptr);
+        CATCH_REQUIRE(f.get_mesh(U'A') == ma);
+        ftmesh::mesh::pointer_t mv(f.get_mesh(U'V'));
+        CATCH_REQUIRE(f.get_mesh_by_index(v) == mv);
+        CATCH_REQUIRE(f.get_mesh_by_index(count) == nullptr);
+
+        float const kerning(f.get_kerning_by_index(a, v));
+        CATCH_REQUIRE(kerning == f.get_kerning(U'A', U'V'));
+        CATCH_REQUIRE(f.get_kerning_by_index(a, v) == kerning);
+
+        ftmesh::shaped_glyph::vector_t shaped(3);
+        shaped[0].f_index = a;
+        shaped[0].f_code_point = U'A';
+        shaped[0].f_x_advance = ma->get_advance() + kerning;
+        shaped[1].f_index = count;      // invalid, skipped but moves the pen
+        shaped[1].f_x_advance = 5.0f;
+        shaped[2].f_index = v;
+        shaped[2].f_x_advance = mv->get_advance();
+        shaped[2].f_x_offset = 1.0f;
+        shaped[2].f_y_offset = -2.0f;
+
+        ftmesh::positioned_glyph::vector_t const glyphs(f.convert_glyphs(shaped, 10.0f, 20.0f));
+        CATCH_REQUIRE(glyphs.size() == 2);
+        CATCH_REQUIRE(glyphs[0].f_mesh == ma);
+        CATCH_REQUIRE(glyphs[0].f_code_point == U'A');
+        CATCH_REQUIRE(glyphs[0].f_x == 10.0f);
+        CATCH_REQUIRE(glyphs[0].f_y == 20.0f);
+        CATCH_REQUIRE(glyphs[1].f_mesh == mv);
+        CATCH_REQUIRE(glyphs[1].f_code_point == U'\0');
+        CATCH_REQUIRE(glyphs[1].f_x == 10.0f + ma->get_advance() + kerning + 5.0f + 1.0f);
+        CATCH_REQUIRE(glyphs[1].f_y == 18.0f);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Shape strings")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        CATCH_REQUIRE(f.shape(U"").empty());
+
+        ftmesh::shaped_glyph::vector_t const shaped(f.shape("AVA"));
+        CATCH_REQUIRE(shaped.size() == 3);
+        CATCH_REQUIRE(shaped[0].f_code_point == U'A');
+        CATCH_REQUIRE(shaped[1].f_code_point == U'V');
+        CATCH_REQUIRE(shaped[2].f_code_point == U'A');
+        CATCH_REQUIRE(shaped[0].f_index == shaped[2].f_index);
+        CATCH_REQUIRE(shaped[0].f_index != shaped[1].f_index);
+
+        // the glyphs go straight to the mesh cache
+        //
+        ftmesh::positioned_glyph::vector_t const glyphs(f.convert_glyphs(shaped));
+        CATCH_REQUIRE(glyphs.size() == 3);
+        CATCH_REQUIRE(glyphs[0].f_mesh == f.get_mesh(U'A'));
+        CATCH_REQUIRE(glyphs[1].f_mesh == f.get_mesh(U'V'));
+        CATCH_REQUIRE(glyphs[2].f_mesh == glyphs[0].f_mesh);
+        CATCH_REQUIRE(glyphs[0].f_x == 0.0f);
+        CATCH_REQUIRE(glyphs[1].f_x > 0.0f);
+        CATCH_REQUIRE(glyphs[2].f_x > glyphs[1].f_x);
+
+        if(!ftmesh::font::has_shaping())
+        {
+            // without HarfBuzz, the layout is the same as convert_string()
+            //
+            float const width(shaped[0].f_x_advance + shaped[1].f_x_advance + shaped[2].f_x_advance);
+            CATCH_REQUIRE(width == f.string_width(U"AVA"));
+            CATCH_REQUIRE(shaped[0].f_x_advance == f.get_mesh(U'A')->get_advance() + f.get_kerning(U'A', U'V'));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Shape strings with GPOS kerning and marks")
+    {
+        // this font has no legacy 'kern' table, only GPOS features
+        //
+        ftmesh::font f(FTMESH_TEST_FONTS_DIR "/shaping.ttf");
+        float const a_advance(f.get_mesh(U'A')->get_advance());
+        CATCH_REQUIRE(f.get_kerning(U'A', U'V') == 0.0f);
+
+        ftmesh::shaped_glyph::vector_t const kerned(f.shape("AV"));
+        CATCH_REQUIRE(kerned.size() == 2);
+        ftmesh::shaped_glyph::vector_t const marked(f.shape("A\xCC\x81V"));
+        CATCH_REQUIRE(marked.size() == 3);
+        CATCH_REQUIRE(marked[2].f_code_point == U'V');
+        CATCH_REQUIRE(f.shape(U"A\u0301V").size() == 3);
+
+        if(ftmesh::font::has_shaping())
+        {
+            // the "kern" feature moves the V closer to the A
+            //
+            CATCH_REQUIRE(kerned[0].f_x_advance < a_advance);
+
+            // the "mark" feature moves the accent over the A (anchor at
+            // x = 300 units) without advancing; it is part of the cluster
+            // of the A
+            //
+            CATCH_REQUIRE(marked[1].f_code_point == U'A');
+            CATCH_REQUIRE(marked[1].f_x_advance == 0.0f);
+            CATCH_REQUIRE(marked[1].f_x_offset < 0.0f);
+            CATCH_REQUIRE(marked[1].f_y_offset > 0.0f);
+        }
+        else
+        {
+            CATCH_REQUIRE(kerned[0].f_x_advance == a_advance);
+            CATCH_REQUIRE(marked[1].f_code_point == U'\u0301');
+            CATCH_REQUIRE(marked[1].f_x_offset == 0.0f);
+            CATCH_REQUIRE(marked[1].f_y_offset == 0.0f);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Composites referencing themselves")
+    {
+        char const * filename("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+
+        FT_Library library(nullptr);
+        CATCH_REQUIRE(FT_Init_FreeType(&library) == FT_Err_Ok);
+        FT_Face face(nullptr);
+        CATCH_REQUIRE(FT_New_Face(library, filename, 0, &face) == FT_Err_Ok);
+        std::uint32_t const aacute(FT_Get_Char_Index(face, U'Á'));
+        std::uint32_t const eacute(FT_Get_Char_Index(face, U'É'));
+        std::uint32_t const iacute(FT_Get_Char_Index(face, U'Í'));
+        FT_Done_Face(face);
+        FT_Done_FreeType(library);
+
+        // Á uses itself, É and Í use each other
+        //
+        std::string const hostile(create_hostile_font(
+                  filename
+                , {
+                      { aacute, aacute }
+                    , { eacute, iacute }
+                    , { iacute, eacute }
+                  }));
+
+        ftmesh::font f(hostile);
+        f.set_reuse_composites(true);
+        for(char32_t const c : { U'Á', U'É', U'Í' })
+        {
+            ftmesh::mesh::pointer_t h(f.get_mesh(c));
+            CATCH_REQUIRE((h == nullptr || !h->is_composite()));
+        }
+
+        // the other glyphs are not affected
+        //
+        ftmesh::mesh::pointer_t m(f.get_mesh(U'Ó'));
+        CATCH_REQUIRE(m != nullptr);
+        CATCH_REQUIRE(m->is_composite());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Damaged shared memory segments are not trusted")
+    {
+        std::string const name("/ftmesh-test-damaged-" + std::to_string(getpid()));
+        shm_unlink(name.c_str());
+        std::size_t const size(1024 * 1024);
+
+        // a creator which died before initializing the header leaves a
+        // segment of the right size full of zeroes
+        //
+        int const fd(shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600));
+        CATCH_REQUIRE(fd >= 0);
+        CATCH_REQUIRE(ftruncate(fd, static_cast<off_t>(size)) == 0);
+        close(fd);
+
+        ftmesh::font a("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        a.set_shared_cache(name, size);
+        ftmesh::mesh::pointer_t ma(a.get_mesh(U'g'));
+
+        // damage the first record and the next offset; the header is
+        // 32 bytes followed by size / 512 slots
+        //
+        int const damage(shm_open(name.c_str(), O_RDWR, 0600));
+        CATCH_REQUIRE(damage >= 0);
+        void * data(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, damage, 0));
+        close(damage);
+        CATCH_REQUIRE(data != MAP_FAILED);
+        std::uint64_t const first_record(32 + size / 512 * sizeof(std::uint64_t));
+        std::uint32_t const point_count(0xFFFFFFF0);
+        std::memcpy(static_cast<char *>(data) + first_record + 28, &point_count, sizeof(point_count));
+        std::uint64_t const next(0xFFFFFFFFFFFFFF00ULL);
+        std::memcpy(static_cast<char *>(data) + 24, &next, sizeof(next));
+        munmap(data, size);
+
+        ftmesh::font b("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        b.set_shared_cache(name, size);
+        ftmesh::mesh::pointer_t mb(b.get_mesh(U'g'));
+        CATCH_REQUIRE(mb != nullptr);
+        CATCH_REQUIRE(mb->get_points().size() == ma->get_points().size());
+        CATCH_REQUIRE(b.get_mesh(U'h') != nullptr);
+
+        shm_unlink(name.c_str());
+    }
+    CATCH_END_SECTION()
+
 }
 
 
@@ -0,0 +1,151 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/font_collection.h>
+
+
+// C++
+//
+#include    <fstream>
+#include    <iterator>
+
+
+
+namespace
+{
+
+
+std::uint32_t read_uint32(std::string const & data, std::size_t offset)
+{
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(data[offset + 0])) << 24)
+         | (static_cast<std::uint32_t>(static_cast<unsigned char>(data[offset + 1])) << 16)
+         | (static_cast<std::uint32_t>(static_cast<unsigned char>(data[offset + 2])) <<  8)
+         |  static_cast<std::uint32_t>(static_cast<unsigned char>(data[offset + 3]));
+}
+
+
+void write_uint32(std::string & data, std::size_t offset, std::uint32_t value)
+{
+    data[offset + 0] = static_cast<char>(value >> 24);
+    data[offset + 1] = static_cast<char>(value >> 16);
+    data[offset + 2] = static_cast<char>(value >>  8);
+    data[offset + 3] = static_cast<char>(value);
+}
+
+
+// create a collection where two faces share the tables of one TTF file
+//
+std::string create_collection(std::string const & ttf)
+{
+    std::ifstream in(ttf, std::ios::binary);
+    std::string font((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::uint32_t const header_size(12 + 2 * 4);
+    std::size_t const table_count((static_cast<unsigned char>(font[4]) << 8) | static_cast<unsigned char>(font[5]));
+    for(std::size_t idx(0); idx < table_count; ++idx)
+    {
+        std::size_t const offset(12 + idx * 16 + 8);
+        write_uint32(font, offset, read_uint32(font, offset) + header_size);
+    }
+
+    std::string collection("ttcf", 4);
+    collection.resize(header_size);
+    write_uint32(collection, 4, 0x00010000);
+    write_uint32(collection, 8, 2);
+    write_uint32(collection, 12, header_size);
+    write_uint32(collection, 16, header_size);
+    collection += font;
+
+    std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/collection.ttc");
+    std::ofstream out(filename, std::ios::binary);
+    out.write(collection.data(), collection.size());
+    return filename;
+}
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("font_collection", "[font][font_collection]")
+{
+    CATCH_START_SECTION("A regular font is a collection of one face")
+    {
+        ftmesh::font_collection c("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        CATCH_REQUIRE(c.get_filename() == "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        CATCH_REQUIRE(c.get_face_count() == 1);
+        CATCH_REQUIRE(c.get_face_name(0) == "DejaVu Sans Book");
+        CATCH_REQUIRE(c.get_font(0)->get_mesh(U'A') != nullptr);
+
+        CATCH_REQUIRE_THROWS_AS(c.get_face_name(1), std::out_of_range);
+        CATCH_REQUIRE_THROWS_AS(c.get_font(-1), std::out_of_range);
+        CATCH_REQUIRE_THROWS_AS(c.get_font(1), std::out_of_range);
+
+        CATCH_REQUIRE_THROWS_AS(ftmesh::font("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", 1), std::runtime_error);
+        CATCH_REQUIRE_THROWS_AS(ftmesh::font("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", -1), std::out_of_range);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Faces of a collection share their meshes")
+    {
+        std::string const filename(create_collection("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"));
+
+        ftmesh::font_collection c(filename);
+        CATCH_REQUIRE(c.get_face_count() == 2);
+        CATCH_REQUIRE(c.get_face_name(1) == "DejaVu Sans Book");
+
+        ftmesh::font::pointer_t first(c.get_font(0));
+        ftmesh::font::pointer_t second(c.get_font(1, ftmesh::open_mode_t::OPEN_MODE_LAZY));
+        CATCH_REQUIRE_FALSE(second->is_open());
+
+        ftmesh::mesh::pointer_t a(first->get_mesh(U'a'));
+        std::size_t const count(c.get_outline_count());
+        CATCH_REQUIRE(count > 0);
+        CATCH_REQUIRE(second->get_mesh(U'a') == a);
+        CATCH_REQUIRE(c.get_outline_count() == count);
+
+        // different settings do not share meshes
+        //
+        ftmesh::font::pointer_t large(c.get_font(1));
+        large->set_size(24, 72, 72);
+        ftmesh::mesh::pointer_t b(large->get_mesh(U'a'));
+        CATCH_REQUIRE(b != a);
+        CATCH_REQUIRE(b->get_advance() > a->get_advance());
+        CATCH_REQUIRE(c.get_outline_count() == count + 1);
+
+        // a font opened directly gets the same result without sharing
+        //
+        ftmesh::font direct(filename, 1);
+        ftmesh::mesh::pointer_t d(direct.get_mesh(U'a'));
+        CATCH_REQUIRE(d != a);
+        CATCH_REQUIRE(d->get_advance() == a->get_advance());
+        CATCH_REQUIRE(d->get_points().size() == a->get_points().size());
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,116 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/font_stack.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <iterator>
+
+
+
+CATCH_TEST_CASE("font_stack", "[font][font_stack]")
+{
+    CATCH_START_SECTION("Characters get their mesh from the first font including them")
+    {
+        ftmesh::font::pointer_t mono(std::make_shared<ftmesh::font>("/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf"));
+        ftmesh::font::pointer_t sans(std::make_shared<ftmesh::font>("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"));
+
+        std::u32string const mono_characters(mono->get_characters());
+        std::u32string const sans_characters(sans->get_characters());
+        CATCH_REQUIRE(std::is_sorted(mono_characters.begin(), mono_characters.end()));
+        CATCH_REQUIRE(mono_characters.find(U'A') != std::u32string::npos);
+
+        // find characters only available in the second font
+        //
+        std::u32string sans_only;
+        std::set_difference(
+                  sans_characters.begin(), sans_characters.end()
+                , mono_characters.begin(), mono_characters.end()
+                , std::back_inserter(sans_only));
+        CATCH_REQUIRE(sans_only.length() > 2);
+
+        ftmesh::font_stack stack;
+        CATCH_REQUIRE(stack.size() == 0);
+        CATCH_REQUIRE(stack.find_font(U'A') == nullptr);
+        CATCH_REQUIRE(stack.get_mesh(U'A') == nullptr);
+        CATCH_REQUIRE(stack.convert_string(U"empty")->empty());
+
+        stack.add_font(mono);
+        stack.add_font(sans);
+        CATCH_REQUIRE(stack.size() == 2);
+        CATCH_REQUIRE(stack.get_font(0) == mono);
+        CATCH_REQUIRE(stack.get_font(1) == sans);
+        CATCH_REQUIRE_THROWS_AS(stack.get_font(2), std::out_of_range);
+
+        CATCH_REQUIRE(stack.find_font(U'A') == mono);
+        CATCH_REQUIRE(stack.get_mesh(U'A') == mono->get_mesh(U'A'));
+        for(char32_t const c : sans_only)
+        {
+            CATCH_REQUIRE(stack.find_font(c) == sans);
+        }
+        CATCH_REQUIRE(stack.get_mesh(sans_only[0]) == sans->get_mesh(sans_only[0]));
+
+        // characters no font includes use the missing glyph of the first font
+        //
+        CATCH_REQUIRE(stack.find_font(U'\U0010FFFD') == nullptr);
+        CATCH_REQUIRE(stack.find_font(static_cast<char32_t>(0x110000)) == nullptr);
+        CATCH_REQUIRE(stack.get_mesh(U'\U0010FFFD') == mono->get_mesh(U'\U0010FFFD'));
+
+        std::u32string const message(U"Mix " + sans_only.substr(0, 2) + U" AV");
+        ftmesh::mesh_string::pointer_t s(stack.convert_string(message));
+        CATCH_REQUIRE(s->size() == message.length());
+        float width(0.0f);
+        for(std::size_t idx(0); idx < s->size(); ++idx)
+        {
+            ftmesh::font::pointer_t const f(idx == 4 || idx == 5 ? sans : mono);
+            CATCH_REQUIRE((*s)[idx]->get_code_point() == message[idx]);
+            CATCH_REQUIRE((*s)[idx]->get_mesh() == f->get_mesh(message[idx]));
+
+            float advance(f->get_mesh(message[idx])->get_advance());
+            if(idx + 1 < message.length()
+            && stack.find_font(message[idx + 1]) == f)
+            {
+                advance += f->get_kerning(message[idx], message[idx + 1]);
+            }
+            CATCH_REQUIRE((*s)[idx]->get_advance() == advance);
+            width += advance;
+        }
+        CATCH_REQUIRE(s->get_width() == width);
+        CATCH_REQUIRE(stack.string_width(message) == width);
+
+        // a string covered by the first font is converted as that font would
+        //
+        CATCH_REQUIRE(stack.string_width("AVA Ta") == mono->string_width("AVA Ta"));
+        CATCH_REQUIRE(stack.convert_string("AVA Ta")->get_width() == mono->convert_string(U"AVA Ta")->get_width());
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
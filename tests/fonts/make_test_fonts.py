@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+#
+# https://snapwebsites.org/project/ftmesh
+# contact@m2osw.com
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Generate the small fonts used by the unit tests. The generated files
+# are saved in the repository so fontTools is not needed to run the
+# tests, only to change the fonts:
+#
+#     python3 tests/fonts/make_test_fonts.py
+#
+# variable.ttf -- a "wght" axis from 100 to 900, default 400, and three
+#                 named instances: Light (300), Regular (400) and Bold (700)
+#                 the stems of "A" and "V" and their advance get wider
+#                 with the weight
+#
+# shaping.ttf  -- "A", "V" and a combining acute accent (U+0301) with a
+#                 GPOS "kern" feature (A V is -150 units) and a GPOS "mark"
+#                 feature placing the accent over the "A"; there is no
+#                 legacy 'kern' table so only a shaper moves these glyphs
+
+import os
+
+from fontTools.feaLib.builder import addOpenTypeFeaturesFromString
+from fontTools.fontBuilder import FontBuilder
+from fontTools.pens.ttGlyphPen import TTGlyphPen
+from fontTools.ttLib.tables.TupleVariation import TupleVariation
+
+
+UNITS_PER_EM = 1000
+
+
+def rectangles(boxes):
+    pen = TTGlyphPen(None)
+    for (x_min, y_min, x_max, y_max) in boxes:
+        pen.moveTo((x_min, y_min))
+        pen.lineTo((x_min, y_max))
+        pen.lineTo((x_max, y_max))
+        pen.lineTo((x_max, y_min))
+        pen.closePath()
+    return pen.glyph()
+
+
+def make_variable_font(filename):
+    glyph_order = ['.notdef', 'space', 'A', 'V']
+    fb = FontBuilder(UNITS_PER_EM, isTTF=True)
+    fb.setupGlyphOrder(glyph_order)
+    fb.setupCharacterMap({0x20: 'space', 0x41: 'A', 0x56: 'V'})
+    fb.setupGlyf({
+        '.notdef': rectangles([]),
+        'space': rectangles([]),
+        'A': rectangles([(50, 0, 150, 700), (450, 0, 550, 700), (150, 300, 450, 400)]),
+        'V': rectangles([(50, 100, 150, 700), (450, 100, 550, 700), (50, 0, 550, 100)]),
+    })
+    fb.setupHorizontalMetrics({
+        '.notdef': (600, 0),
+        'space': (300, 0),
+        'A': (600, 50),
+        'V': (600, 50),
+    })
+    fb.setupHorizontalHeader(ascent=800, descent=-200)
+    fb.setupNameTable({'familyName': 'ftmesh Variable', 'styleName': 'Regular'})
+    fb.setupOS2(sTypoAscender=800, sTypoDescender=-200, usWinAscent=800, usWinDescent=200)
+    fb.setupPost()
+    fb.setupFvar(
+        axes=[('wght', 100, 400, 900, 'Weight')],
+        instances=[
+            {'stylename': 'Light', 'location': {'wght': 300}},
+            {'stylename': 'Regular', 'location': {'wght': 400}},
+            {'stylename': 'Bold', 'location': {'wght': 700}},
+        ])
+
+    # at the maximum weight, the right stems move right by 200 units;
+    # the 4 last deltas are the phantom points (the advance moves too)
+    #
+    stems = [(0, 0)] * 4 + [(200, 0)] * 4 + [(0, 0), (0, 0), (200, 0), (200, 0)]
+    phantoms = [(0, 0), (200, 0), (0, 0), (0, 0)]
+    fb.setupGvar({
+        '.notdef': [],
+        'space': [],
+        'A': [TupleVariation({'wght': (0.0, 1.0, 1.0)}, stems + phantoms)],
+        'V': [TupleVariation({'wght': (0.0, 1.0, 1.0)}, stems + phantoms)],
+    })
+    fb.save(filename)
+
+
+def make_shaping_font(filename):
+    glyph_order = ['.notdef', 'space', 'A', 'V', 'acutecomb']
+    fb = FontBuilder(UNITS_PER_EM, isTTF=True)
+    fb.setupGlyphOrder(glyph_order)
+    fb.setupCharacterMap({0x20: 'space', 0x41: 'A', 0x56: 'V', 0x301: 'acutecomb'})
+    fb.setupGlyf({
+        '.notdef': rectangles([]),
+        'space': rectangles([]),
+        'A': rectangles([(50, 0, 150, 700), (450, 0, 550, 700), (150, 300, 450, 400)]),
+        'V': rectangles([(50, 100, 150, 700), (450, 100, 550, 700), (50, 0, 550, 100)]),
+        'acutecomb': rectangles([(-100, 0, 100, 100)]),
+    })
+    fb.setupHorizontalMetrics({
+        '.notdef': (600, 0),
+        'space': (300, 0),
+        'A': (600, 50),
+        'V': (600, 50),
+        'acutecomb': (0, -100),
+    })
+    fb.setupHorizontalHeader(ascent=800, descent=-200)
+    fb.setupNameTable({'familyName': 'ftmesh Shaping', 'styleName': 'Regular'})
+    fb.setupOS2(sTypoAscender=800, sTypoDescender=-200, usWinAscent=800, usWinDescent=200)
+    fb.setupPost()
+    addOpenTypeFeaturesFromString(fb.font, '''
+        languagesystem DFLT dflt;
+        languagesystem latn dflt;
+
+        markClass acutecomb <anchor 0 0> @TOP;
+
+        feature kern {
+            pos A V -150;
+        } kern;
+
+        feature mark {
+            pos base [A V] <anchor 300 750> mark @TOP;
+        } mark;
+
+        table GDEF {
+            GlyphClassDef [A V], , [acutecomb], ;
+        } GDEF;
+    ''')
+    fb.save(filename)
+
+
+if __name__ == '__main__':
+    directory = os.path.dirname(os.path.abspath(__file__))
+    make_variable_font(os.path.join(directory, 'variable.ttf'))
+    make_shaping_font(os.path.join(directory, 'shaping.ttf'))
@@ -0,0 +1,152 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/layout.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_reached.h>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+// we're testing many of those here so ignore warnings
+//
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+
+
+CATCH_TEST_CASE("layout", "[layout]")
+{
+    CATCH_START_SECTION("Paragraph broken at spaces")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::layout l(f);
+
+        // without a maximum width only newlines break the text
+        //
+        l.convert(U"one two three\nfour");
+        CATCH_REQUIRE(l.get_lines().size() == 2);
+        CATCH_REQUIRE(l.get_lines()[0].f_glyph_count == 13);
+        CATCH_REQUIRE(l.get_lines()[1].f_glyph_count == 4);
+        CATCH_REQUIRE(l.get_lines()[0].f_width == f.string_width(U"one two three"));
+        CATCH_REQUIRE(l.get_lines()[1].f_y == -f.get_line_height());
+        CATCH_REQUIRE(l.get_width() == l.get_lines()[0].f_width);
+        CATCH_REQUIRE(l.get_height() == 2.0f * f.get_line_height());
+
+        // "three four" is the widest line that fits
+        //
+        float const max_width(f.string_width(U"three four") + 1.0f);
+        CATCH_REQUIRE(f.string_width(U"one two three") > max_width);
+        CATCH_REQUIRE(f.string_width(U"three four five") > max_width);
+        l.set_max_width(max_width);
+        l.convert("one two three four five six");
+
+        std::u32string const expected[] = { U"one two", U"three four", U"five six" };
+        ftmesh::layout::line_vector_t const & lines(l.get_lines());
+        ftmesh::positioned_glyph::vector_t const & glyphs(l.get_glyphs());
+        CATCH_REQUIRE(lines.size() == std::size(expected));
+        for(std::size_t idx(0); idx < lines.size(); ++idx)
+        {
+            std::u32string text;
+            for(std::size_t g(0); g < lines[idx].f_glyph_count; ++g)
+            {
+                text += glyphs[lines[idx].f_first_glyph + g].f_code_point;
+            }
+            CATCH_REQUIRE(text == expected[idx]);
+            CATCH_REQUIRE(lines[idx].f_width <= max_width);
+            CATCH_REQUIRE(lines[idx].f_width == f.string_width(expected[idx]));
+            CATCH_REQUIRE(lines[idx].f_x == 0.0f);
+            CATCH_REQUIRE(glyphs[lines[idx].f_first_glyph].f_x == 0.0f);
+            CATCH_REQUIRE(glyphs[lines[idx].f_first_glyph].f_y == -static_cast<float>(idx) * f.get_line_height());
+        }
+
+        // a word longer than the line gets broken between characters
+        //
+        l.set_max_width(f.string_width(U"abc") + 0.5f);
+        l.convert(U"abcdefgh");
+        CATCH_REQUIRE(l.get_lines().size() == 3);
+        CATCH_REQUIRE(l.get_lines()[0].f_glyph_count == 3);
+        CATCH_REQUIRE(l.get_lines()[1].f_glyph_count == 3);
+        CATCH_REQUIRE(l.get_lines()[2].f_glyph_count == 2);
+
+        CATCH_REQUIRE_THROWS(l.set_max_width(-1.0f));
+        CATCH_REQUIRE_THROWS(l.set_line_height(-1.0f));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Paragraph alignment")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::layout l(f);
+        l.set_max_width(500.0f);
+        l.set_line_height(100.0f);
+
+        l.set_alignment(ftmesh::align_t::ALIGN_RIGHT);
+        l.convert(U"right\nside");
+        CATCH_REQUIRE(l.get_lines().size() == 2);
+        CATCH_REQUIRE(l.get_lines()[0].f_x == 500.0f - f.string_width(U"right"));
+        CATCH_REQUIRE(l.get_lines()[1].f_x == 500.0f - f.string_width(U"side"));
+        CATCH_REQUIRE(l.get_lines()[1].f_y == -100.0f);
+        CATCH_REQUIRE(l.get_height() == 200.0f);
+
+        l.set_alignment(ftmesh::align_t::ALIGN_CENTER);
+        l.convert(U"middle");
+        CATCH_REQUIRE(l.get_lines()[0].f_x == (500.0f - f.string_width(U"middle")) / 2.0f);
+        CATCH_REQUIRE(l.get_glyphs()[0].f_x == l.get_lines()[0].f_x);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("UTF-8 and UTF-32 paragraphs give the same layout")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::layout utf8(f);
+        ftmesh::layout utf32(f);
+        utf8.set_max_width(f.string_width(U"Ça déjà") + 1.0f);
+        utf32.set_max_width(f.string_width(U"Ça déjà") + 1.0f);
+
+        utf8.convert(std::string("Ça déjà été\nvu"));
+        utf32.convert(U"Ça déjà été\nvu");
+        CATCH_REQUIRE(utf8.get_lines().size() == 3);
+        CATCH_REQUIRE(utf32.get_lines().size() == 3);
+        CATCH_REQUIRE(utf8.get_glyphs().size() == utf32.get_glyphs().size());
+        for(std::size_t idx(0); idx < utf8.get_glyphs().size(); ++idx)
+        {
+            CATCH_REQUIRE(utf8.get_glyphs()[idx].f_code_point == utf32.get_glyphs()[idx].f_code_point);
+            CATCH_REQUIRE(utf8.get_glyphs()[idx].f_x == utf32.get_glyphs()[idx].f_x);
+            CATCH_REQUIRE(utf8.get_glyphs()[idx].f_y == utf32.get_glyphs()[idx].f_y);
+        }
+        CATCH_REQUIRE(utf8.get_glyphs()[0].f_code_point == U'Ç');
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,220 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/mesh.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_reached.h>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+// we're testing many of those here so ignore warnings
+//
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+
+namespace
+{
+
+
+// a square made of two triangles sharing the (1, 0) to (0, 1) edge
+//
+ftmesh::mesh::pointer_t create_square()
+{
+    ftmesh::mesh::pointer_t m(std::make_shared<ftmesh::mesh>(10.0f));
+    m->begin();
+    m->add_point(ftmesh::point(0.0, 0.0));
+    m->add_point(ftmesh::point(1.0, 0.0));
+    m->add_point(ftmesh::point(0.0, 1.0));
+    m->add_point(ftmesh::point(1.0, 0.0));
+    m->add_point(ftmesh::point(1.0, 1.0));
+    m->add_point(ftmesh::point(0.0, 1.0));
+    m->end();
+    return m;
+}
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("mesh", "[mesh]")
+{
+    CATCH_START_SECTION("Default mesh is a list of triangles")
+    {
+        ftmesh::mesh::pointer_t m(create_square());
+
+        CATCH_REQUIRE(m->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLES);
+        CATCH_REQUIRE(m->get_points().size() == 6);
+        CATCH_REQUIRE(m->get_indexes().size() == 1);
+        CATCH_REQUIRE(m->get_elements().empty());
+        CATCH_REQUIRE(m->get_advance() == 10.0f);
+
+        m->optimize(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLES);
+        CATCH_REQUIRE(m->get_points().size() == 6);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Bounds and bearings")
+    {
+        ftmesh::mesh m(5.0f);
+        CATCH_REQUIRE(m.get_bounds().is_empty());
+        CATCH_REQUIRE(m.get_bounds().width() == 0.0);
+
+        ftmesh::mesh::pointer_t s(create_square());
+        CATCH_REQUIRE_FALSE(s->get_bounds().is_empty());
+        CATCH_REQUIRE(s->get_bounds().f_min.x() == 0.0);
+        CATCH_REQUIRE(s->get_bounds().f_min.y() == 0.0);
+        CATCH_REQUIRE(s->get_bounds().f_max.x() == 1.0);
+        CATCH_REQUIRE(s->get_bounds().f_max.y() == 1.0);
+
+        s->set_bearing(0.25f, 1.5f);
+        CATCH_REQUIRE(s->get_bearing_x() == 0.25f);
+        CATCH_REQUIRE(s->get_bearing_y() == 1.5f);
+
+        // the optimization does not change the bounds
+        //
+        s->optimize(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        CATCH_REQUIRE(s->get_bounds().width() == 1.0);
+        CATCH_REQUIRE(s->get_bounds().height() == 1.0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Indexed triangles share their vertices")
+    {
+        ftmesh::mesh::pointer_t m(create_square());
+        m->optimize(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+
+        CATCH_REQUIRE(m->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        CATCH_REQUIRE(m->get_points().size() == 4);
+        CATCH_REQUIRE(m->get_indexes().empty());
+        CATCH_REQUIRE(m->get_elements().size() == 6);
+        for(auto const e : m->get_elements())
+        {
+            CATCH_REQUIRE(e < 4);
+        }
+
+        // vertices are renumbered in the order they are used
+        //
+        CATCH_REQUIRE(m->get_elements()[0] == 0);
+
+        CATCH_REQUIRE_THROWS_AS(
+                  m->optimize(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS)
+                , std::logic_error);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Triangle strips")
+    {
+        ftmesh::mesh::pointer_t m(create_square());
+        m->optimize(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+
+        // the two triangles form a single strip of 4 vertices
+        //
+        CATCH_REQUIRE(m->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        CATCH_REQUIRE(m->get_points().size() == 4);
+        CATCH_REQUIRE(m->get_elements().size() == 4);
+        for(auto const e : m->get_elements())
+        {
+            CATCH_REQUIRE(e != ftmesh::PRIMITIVE_RESTART_INDEX);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Composite mesh")
+    {
+        ftmesh::mesh::pointer_t square(create_square());
+        square->optimize(ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+
+        ftmesh::mesh composite(3.0f);
+        CATCH_REQUIRE_FALSE(composite.is_composite());
+
+        ftmesh::mesh::component c;
+        c.f_mesh = square;
+        composite.add_component(c);
+
+        c.f_matrix[0] = 2.0;        // scale x by 2
+        c.f_matrix[4] = 5.0;        // move by (5, -1)
+        c.f_matrix[5] = -1.0;
+        composite.add_component(c);
+
+        CATCH_REQUIRE(composite.is_composite());
+        CATCH_REQUIRE(composite.get_components().size() == 2);
+        CATCH_REQUIRE(composite.get_format() == ftmesh::mesh_format_t::MESH_FORMAT_TRIANGLE_STRIPS);
+        CATCH_REQUIRE(composite.get_points().empty());
+        CATCH_REQUIRE(composite.get_bounds().f_min.x() == 0.0);
+        CATCH_REQUIRE(composite.get_bounds().f_min.y() == -1.0);
+        CATCH_REQUIRE(composite.get_bounds().f_max.x() == 7.0);
+        CATCH_REQUIRE(composite.get_bounds().f_max.y() == 1.0);
+
+        ftmesh::mesh::pointer_t flat(composite.flatten());
+        CATCH_REQUIRE_FALSE(flat->is_composite());
+        CATCH_REQUIRE(flat->get_advance() == 3.0f);
+        CATCH_REQUIRE(flat->get_points().size() == 8);
+        CATCH_REQUIRE(flat->get_elements().size() == 9);       // 4 + restart + 4
+        CATCH_REQUIRE(flat->get_elements()[4] == ftmesh::PRIMITIVE_RESTART_INDEX);
+        CATCH_REQUIRE(flat->get_bounds().f_max.x() == 7.0);
+
+        // a composite can't mix formats
+        //
+        c.f_mesh = create_square();
+        CATCH_REQUIRE_THROWS_AS(composite.add_component(c), std::logic_error);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Copy a mesh to a slab")
+    {
+        ftmesh::slab::pointer_t storage(std::make_shared<ftmesh::slab>(1024));
+        CATCH_REQUIRE(storage->get_used() == 0);
+
+        ftmesh::mesh::pointer_t square(create_square());
+        square->optimize(ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        ftmesh::mesh::pointer_t copy(square->copy(storage));
+
+        CATCH_REQUIRE(copy->get_points().get_allocator().resource() == storage.get());
+        CATCH_REQUIRE(copy->get_points().size() == 4);
+        CATCH_REQUIRE(copy->get_elements().size() == 6);
+        CATCH_REQUIRE(copy->get_format() == ftmesh::mesh_format_t::MESH_FORMAT_INDEXED_TRIANGLES);
+        CATCH_REQUIRE(copy->get_bounds().width() == 1.0);
+        CATCH_REQUIRE(storage->get_used() == 4 * sizeof(ftmesh::point) + 6 * sizeof(std::uint32_t));
+
+        // the points of the copy come right after each other in the slab
+        //
+        ftmesh::mesh::pointer_t second(square->copy(storage));
+        CATCH_REQUIRE(reinterpret_cast<char const *>(second->get_points().data())
+                    > reinterpret_cast<char const *>(copy->get_points().data()));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
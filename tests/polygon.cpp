@@ -0,0 +1,120 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/polygon.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_reached.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <iterator>
+
+
+// we're testing many of those here so ignore warnings
+//
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+
+CATCH_TEST_CASE("polygon", "[polygon]")
+{
+    CATCH_START_SECTION("Simplify drops collinear and duplicate points")
+    {
+        // a square with extra points along its edges, a duplicate and
+        // a point very close to a corner
+        //
+        FT_Vector contour[] =
+        {
+            {   0,   0 },
+            {  50,   0 },
+            { 100,   0 },
+            { 100,   0 },
+            { 100,  30 },
+            { 100, 100 },
+            {  50, 100 },
+            {   0, 100 },
+            {   0,  60 },
+            {   0,  20 },
+        };
+        char tags[std::size(contour)];
+        std::fill(tags, tags + std::size(contour), FT_CURVE_TAG_ON);
+
+        ftmesh::polygon p(contour, tags, std::size(contour));
+        CATCH_REQUIRE(p.size() == 9);      // exact duplicate already ignored
+
+        p.simplify(0.0);
+        CATCH_REQUIRE(p.size() == 9);      // no tolerance, no change
+
+        p.simplify(0.01);
+        CATCH_REQUIRE(p.size() == 4);
+        CATCH_REQUIRE(p.leftmost().x() == 0.0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Simplify removes zero width spikes")
+    {
+        FT_Vector contour[] =
+        {
+            {   0,   0 },
+            { 100,   0 },
+            { 150,   0 },      // spike going right...
+            { 100,   0 },      // ...and coming back
+            { 100, 100 },
+            {   0, 100 },
+        };
+        char tags[std::size(contour)];
+        std::fill(tags, tags + std::size(contour), FT_CURVE_TAG_ON);
+
+        ftmesh::polygon p(contour, tags, std::size(contour));
+        p.simplify(0.01);
+        CATCH_REQUIRE(p.size() == 4);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Simplify a contour down to a degenerate polygon")
+    {
+        FT_Vector contour[] =
+        {
+            {   0,   0 },
+            {  50,   0 },
+            { 100,   0 },
+        };
+        char tags[std::size(contour)];
+        std::fill(tags, tags + std::size(contour), FT_CURVE_TAG_ON);
+
+        ftmesh::polygon p(contour, tags, std::size(contour));
+        p.simplify(0.01);
+        CATCH_REQUIRE(p.size() < 3);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,190 @@
+// Copyright (c) 2021-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/ftmesh
+// contact@m2osw.com
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// self
+//
+#include    "main.h"
+
+
+// ftmesh
+//
+#include    <ftmesh/font.h>
+
+
+// snapdev
+//
+#include    <snapdev/not_reached.h>
+
+
+// C++
+//
+#include    <chrono>
+#include    <fstream>
+#include    <thread>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+
+CATCH_TEST_CASE("usage_profile", "[usage_profile]")
+{
+    CATCH_START_SECTION("Count, save and load a profile")
+    {
+        ftmesh::usage_profile p;
+        for(char32_t c : std::u32string(U"hello world"))
+        {
+            p.record_glyph(c);
+        }
+        p.record_pair(U'l', U'o');
+        p.record_pair(U'l', U'o');
+        p.record_pair(U'W', U'o');
+
+        ftmesh::usage_profile::glyph_count_vector_t glyphs(p.get_glyphs());
+        CATCH_REQUIRE(glyphs.size() == 8);
+        CATCH_REQUIRE(glyphs[0].f_glyph == U'l');
+        CATCH_REQUIRE(glyphs[0].f_count == 3);
+        CATCH_REQUIRE(glyphs[1].f_glyph == U'o');
+        CATCH_REQUIRE(glyphs[1].f_count == 2);
+        CATCH_REQUIRE(p.get_glyphs(2).size() == 2);
+
+        ftmesh::usage_profile::pair_count_vector_t pairs(p.get_pairs());
+        CATCH_REQUIRE(pairs.size() == 2);
+        CATCH_REQUIRE(pairs[0].f_current == U'l');
+        CATCH_REQUIRE(pairs[0].f_next == U'o');
+        CATCH_REQUIRE(pairs[0].f_count == 2);
+
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/usage.profile");
+        p.save(filename);
+
+        ftmesh::usage_profile loaded;
+        loaded.load(filename);
+        ftmesh::usage_profile::glyph_count_vector_t loaded_glyphs(loaded.get_glyphs());
+        CATCH_REQUIRE(loaded_glyphs.size() == glyphs.size());
+        for(std::size_t idx(0); idx < glyphs.size(); ++idx)
+        {
+            CATCH_REQUIRE(loaded_glyphs[idx].f_glyph == glyphs[idx].f_glyph);
+            CATCH_REQUIRE(loaded_glyphs[idx].f_count == glyphs[idx].f_count);
+        }
+        CATCH_REQUIRE(loaded.get_pairs().size() == 2);
+        CATCH_REQUIRE(loaded.get_pairs()[1].f_current == U'W');
+
+        // only keep the top entries
+        //
+        p.save(filename, 1);
+        loaded.clear();
+        loaded.load(filename);
+        CATCH_REQUIRE(loaded.get_glyphs().size() == 1);
+        CATCH_REQUIRE(loaded.get_pairs().size() == 1);
+
+        {
+            std::ofstream out(filename);
+            out << "# bad profile\ng 41 3\nx 42 1\n";
+        }
+        CATCH_REQUIRE_THROWS_AS(loaded.load(filename), std::runtime_error);
+        CATCH_REQUIRE_THROWS_AS(loaded.load(filename + ".missing"), std::runtime_error);
+
+        unlink(filename.c_str());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Record the usage of a font and prewarm another")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        ftmesh::usage_profile::pointer_t p(std::make_shared<ftmesh::usage_profile>());
+        f.set_usage_profile(p);
+        CATCH_REQUIRE(f.get_usage_profile() == p);
+
+        f.convert_string(U"AVAV");
+        f.string_width(U"To");
+        ftmesh::usage_profile::glyph_count_vector_t glyphs(p->get_glyphs());
+        CATCH_REQUIRE(glyphs.size() == 4);
+        CATCH_REQUIRE(glyphs[0].f_glyph == U'A');
+        CATCH_REQUIRE(glyphs[0].f_count == 2);
+        ftmesh::usage_profile::pair_count_vector_t pairs(p->get_pairs());
+        CATCH_REQUIRE(pairs.size() == 3);
+        CATCH_REQUIRE(pairs[0].f_current == U'A');
+        CATCH_REQUIRE(pairs[0].f_next == U'V');
+        CATCH_REQUIRE(pairs[0].f_count == 2);
+
+        ftmesh::font warm("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        warm.prewarm(p);
+        for(auto const & g : glyphs)
+        {
+            CATCH_REQUIRE(warm.get_mesh_async(g.f_glyph).get() != nullptr);
+        }
+        CATCH_REQUIRE(warm.string_width(U"AVAV") == f.string_width(U"AVAV"));
+        CATCH_REQUIRE(warm.get_kerning(U'A', U'V') == f.get_kerning(U'A', U'V'));
+
+        // the string_width() call above counted 2 more A's
+        //
+        CATCH_REQUIRE(p->get_glyphs()[0].f_count == 4);
+        f.set_usage_profile(ftmesh::usage_profile::pointer_t());
+        f.convert_string(U"AV");
+        CATCH_REQUIRE(p->get_glyphs()[0].f_count == 4);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Prewarm the pairs of a font which can't be opened")
+    {
+        ftmesh::usage_profile::pointer_t p(std::make_shared<ftmesh::usage_profile>());
+        p->record_pair(U'A', U'V');
+
+        ftmesh::font missing("/this/font/does/not/exist.ttf", ftmesh::open_mode_t::OPEN_MODE_LAZY);
+        missing.prewarm(p);
+
+        // give the worker time to try the pair, the error must not
+        // escape the thread
+        //
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CATCH_REQUIRE_THROWS_AS(missing.get_kerning(U'A', U'V'), std::runtime_error);
+        CATCH_REQUIRE_FALSE(missing.is_open());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Strings found in the string cache are recorded")
+    {
+        ftmesh::font f("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        f.set_string_cache_size(64 * 1024);
+        ftmesh::usage_profile::pointer_t p(std::make_shared<ftmesh::usage_profile>());
+        f.set_usage_profile(p);
+
+        for(int count(0); count < 3; ++count)
+        {
+            f.convert_string("AVA");
+            f.string_width("AVA");
+        }
+        ftmesh::usage_profile::glyph_count_vector_t glyphs(p->get_glyphs());
+        CATCH_REQUIRE(glyphs.size() == 2);
+        CATCH_REQUIRE(glyphs[0].f_glyph == U'A');
+        CATCH_REQUIRE(glyphs[0].f_count == 12);
+        CATCH_REQUIRE(glyphs[1].f_glyph == U'V');
+        CATCH_REQUIRE(glyphs[1].f_count == 6);
+        ftmesh::usage_profile::pair_count_vector_t pairs(p->get_pairs());
+        CATCH_REQUIRE(pairs.size() == 2);
+        CATCH_REQUIRE(pairs[0].f_count == 6);
+        CATCH_REQUIRE(pairs[1].f_count == 6);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et